@@ -0,0 +1,253 @@
+#include "DbConnectionPool.h"
+#include <QSqlError>
+#include <QThread>
+#include <QDebug>
+
+// Kept outside the pool so thread-exit cleanup never touches a destroyed singleton
+static std::atomic<quint64> g_connectionsOpened { 0 };
+static std::atomic<quint64> g_connectionsClosed { 0 };
+
+DbConnectionPool::ThreadConnection::~ThreadConnection() {
+    statements.clear();  // release prepared statements before closing
+    {
+        QSqlDatabase conn = QSqlDatabase::database(name, false);
+        if (conn.isOpen())
+            conn.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    ++g_connectionsClosed;
+    qDebug() << "🔒 Closed DB connection:" << name;
+}
+
+DbConnectionPool& DbConnectionPool::instance() {
+    static DbConnectionPool inst;
+    return inst;
+}
+
+DbConnectionPool::DbConnectionPool() {
+    maxReaders = qMax(2, QThread::idealThreadCount());
+    readerSlots.release(maxReaders);
+}
+
+void DbConnectionPool::configure(const QString& path, int readers,
+                                 const std::function<void(QSqlDatabase&)>& openHook) {
+    readers = qMax(1, readers);
+    {
+        QMutexLocker locker(&configMutex);
+        dbPath = path;
+        onOpen = openHook;
+
+        if (readers > maxReaders) {
+            // Cancel a pending shrink first, then open the remaining slots
+            int grow = readers - maxReaders;
+            while (grow > 0 && takeSlotToRetire())
+                --grow;
+            readerSlots.release(grow);
+        } else if (readers < maxReaders) {
+            // ✅ Take the free slots now; ones held by live leases go when those end (no wait under the lock)
+            slotsToRetire += maxReaders - readers;
+            while (slotsToRetire.load() > 0 && readerSlots.tryAcquire(1)) {
+                if (!takeSlotToRetire()) {
+                    readerSlots.release(1);  // a lease ending meanwhile already retired the last one
+                    break;
+                }
+            }
+        }
+        maxReaders = readers;
+    }
+
+    // ✅ Bumping the generation makes every thread reopen on its next lease
+    ++generation;
+}
+
+DbConnectionPool::ThreadConnection* DbConnectionPool::threadConnection() {
+    ThreadConnection* tc = connections.localData();
+    if (tc && (tc->generation == generation.load() || tc->activeLeases > 0))
+        return tc;
+
+    if (tc) {
+        connections.setLocalData(nullptr);  // deletes the stale connection
+        tc = nullptr;
+    }
+
+    QString path;
+    std::function<void(QSqlDatabase&)> hook;
+    {
+        QMutexLocker locker(&configMutex);
+        path = dbPath;
+        hook = onOpen;
+    }
+
+    // Unique names: a recycled QThread pointer can never pick up a stale connection
+    tc = new ThreadConnection;
+    tc->name = QString("face_db_%1").arg(nextConnectionId++);
+    tc->generation = generation.load();
+
+    QSqlDatabase conn = QSqlDatabase::addDatabase("QSQLITE", tc->name);
+    conn.setDatabaseName(path);
+    if (path.isEmpty()) {
+        // ❌ Never fall back to SQLite's private in-memory database: leases stay invalid instead
+        qWarning() << "❌ Face database path not configured";
+    } else if (!conn.open()) {
+        qWarning() << "❌ Failed to open SQLite DB in thread:" << conn.lastError().text();
+    } else {
+        ++g_connectionsOpened;
+        if (hook) hook(conn);
+        qDebug() << "✅ Opened DB connection" << tc->name << "for thread" << QThread::currentThread();
+    }
+
+    connections.setLocalData(tc);
+    return tc;
+}
+
+void DbConnectionPool::recordLease(qint64 waitedMs, bool waited) {
+    QMutexLocker locker(&metricsMutex);
+    ++stats.leases;
+    if (waited) {
+        ++stats.waits;
+        stats.totalWaitMs += waitedMs;
+    }
+}
+
+DbConnectionPool::Lease DbConnectionPool::reader() {
+    ThreadConnection* tc = threadConnection();
+
+    bool ownsSlot = false;
+    if (tc->readerDepth == 0) {
+        QElapsedTimer waited;
+        waited.start();
+        bool blocked = !readerSlots.tryAcquire(1);
+        if (blocked)
+            readerSlots.acquire(1);
+        recordLease(waited.elapsed(), blocked);
+        ownsSlot = true;
+    } else {
+        recordLease(0, false);
+    }
+
+    ++tc->readerDepth;
+    ++tc->activeLeases;
+    return Lease(this, false, ownsSlot);
+}
+
+DbConnectionPool::Lease DbConnectionPool::writer() {
+    ThreadConnection* tc = threadConnection();
+
+    QElapsedTimer waited;
+    waited.start();
+    bool blocked = !writerMutex.tryLock();
+    if (blocked)
+        writerMutex.lock();
+    recordLease(waited.elapsed(), blocked);
+
+    ++tc->activeLeases;
+    return Lease(this, true, false);
+}
+
+void DbConnectionPool::release(Lease& lease) {
+    qint64 heldMs = lease.held.elapsed();
+
+    ThreadConnection* tc = connections.localData();
+    if (tc && tc->activeLeases > 0)
+        --tc->activeLeases;
+
+    // Statements go back to the connection, reset so a later lease starts clean
+    if (tc) {
+        for (auto& variants : tc->statements) {
+            for (ThreadConnection::Statement& st : variants) {
+                if (st.owner == lease.id) {
+                    st.query.finish();
+                    st.owner = 0;
+                }
+            }
+        }
+    }
+
+    if (lease.writer) {
+        writerMutex.unlock();
+    } else {
+        if (tc && tc->readerDepth > 0)
+            --tc->readerDepth;
+        if (lease.ownsSlot)
+            releaseReaderSlot();
+    }
+
+    QMutexLocker locker(&metricsMutex);
+    stats.totalLeaseMs += heldMs;
+    stats.maxLeaseMs = qMax(stats.maxLeaseMs, heldMs);
+}
+
+bool DbConnectionPool::takeSlotToRetire() {
+    int retire = slotsToRetire.load();
+    while (retire > 0) {
+        if (slotsToRetire.compare_exchange_weak(retire, retire - 1))
+            return true;
+    }
+    return false;
+}
+
+void DbConnectionPool::releaseReaderSlot() {
+    // The reader limit shrank while this lease was out: the slot goes away instead of back
+    if (!takeSlotToRetire())
+        readerSlots.release(1);
+}
+
+DbPoolMetrics DbConnectionPool::metrics() const {
+    QMutexLocker locker(&metricsMutex);
+    DbPoolMetrics m = stats;
+    m.opens = g_connectionsOpened.load();
+    m.closes = g_connectionsClosed.load();
+    m.openConnections = static_cast<int>(m.opens - m.closes);
+    return m;
+}
+
+DbConnectionPool::Lease::Lease(DbConnectionPool* p, bool w, bool slot)
+    : pool(p), writer(w), ownsSlot(slot), id(p->nextLeaseId++) {
+    held.start();
+}
+
+DbConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), writer(other.writer), ownsSlot(other.ownsSlot), id(other.id), held(other.held) {
+    other.pool = nullptr;
+}
+
+DbConnectionPool::Lease::~Lease() {
+    if (pool)
+        pool->release(*this);
+}
+
+bool DbConnectionPool::Lease::isValid() const {
+    return pool && database().isOpen();
+}
+
+QSqlDatabase DbConnectionPool::Lease::database() const {
+    ThreadConnection* tc = pool ? pool->connections.localData() : nullptr;
+    return tc ? QSqlDatabase::database(tc->name, false) : QSqlDatabase();
+}
+
+QSqlQuery& DbConnectionPool::Lease::prepared(const QString& sql) {
+    ThreadConnection* tc = pool->connections.localData();
+
+    std::list<ThreadConnection::Statement>& variants = tc->statements[sql];
+
+    ThreadConnection::Statement* freeStatement = nullptr;
+    for (ThreadConnection::Statement& st : variants) {
+        if (st.owner == id)
+            return st.query;  // this lease already holds it
+        if (st.owner == 0 && !freeStatement)
+            freeStatement = &st;
+    }
+    if (freeStatement) {
+        freeStatement->owner = id;
+        return freeStatement->query;
+    }
+
+    // First use, or every copy is held by an enclosing lease: prepare another
+    QSqlQuery q(QSqlDatabase::database(tc->name, false));
+    q.setForwardOnly(true);
+    if (!q.prepare(sql)) {
+        qWarning() << "❌ Failed to prepare statement:" << q.lastError().text() << sql;
+    }
+    variants.push_back({ q, id });
+    return variants.back().query;
+}
@@ -0,0 +1,119 @@
+#ifndef DBCONNECTIONPOOL_H
+#define DBCONNECTIONPOOL_H
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QRecursiveMutex>
+#include <QSemaphore>
+#include <QThreadStorage>
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
+#include <list>
+
+struct DbPoolMetrics {
+    quint64 opens = 0;          // connections opened
+    quint64 closes = 0;         // connections closed (thread exit or reconfigure)
+    quint64 leases = 0;         // reader + writer leases handed out
+    quint64 waits = 0;          // leases that had to block for a slot
+    qint64 totalWaitMs = 0;
+    qint64 totalLeaseMs = 0;
+    qint64 maxLeaseMs = 0;
+    int openConnections = 0;
+};
+
+// Bounded access to the face database.
+// Qt only allows a connection to be used on the thread that opened it, so each
+// thread lazily owns one connection that is closed when the thread exits.
+// Connections are therefore not pooled across threads: what is bounded is
+// concurrency, not the number of open connections (a thread that ever leased
+// keeps its connection until it exits). Reader leases are limited by a
+// semaphore; the writer lease is exclusive.
+class DbConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        QSqlDatabase database() const;
+        bool isValid() const;
+
+        // Prepared once per connection, then reused (forward-only). The statement
+        // belongs to this lease until it is released: asking again for the same SQL
+        // returns the same statement, while a nested lease on the same thread (a
+        // helper called from inside a loop over this query) gets a separate one,
+        // so it cannot clobber the outer bindings or result set.
+        QSqlQuery& prepared(const QString& sql);
+
+    private:
+        friend class DbConnectionPool;
+        Lease(DbConnectionPool* pool, bool writer, bool ownsSlot);
+
+        DbConnectionPool* pool = nullptr;
+        bool writer = false;
+        bool ownsSlot = false;
+        quint64 id = 0;
+        QElapsedTimer held;
+    };
+
+    static DbConnectionPool& instance();
+
+    // Drops every thread's connection (lazily) so the next lease opens dbPath.
+    // Never blocks: when the reader limit shrinks, slots held by outstanding
+    // leases are retired as those leases end.
+    void configure(const QString& dbPath, int maxReaders,
+                   const std::function<void(QSqlDatabase&)>& onOpen);
+
+    Lease reader();
+    Lease writer();
+
+    DbPoolMetrics metrics() const;
+
+private:
+    struct ThreadConnection {
+        QString name;
+        quint64 generation = 0;
+        int readerDepth = 0;    // nested reader leases on this thread share one slot
+        int activeLeases = 0;   // never reopen underneath a live lease
+        struct Statement {
+            QSqlQuery query;
+            quint64 owner = 0;  // lease id while handed out, 0 when free
+        };
+        QHash<QString, std::list<Statement>> statements;   // list: stable references
+        ~ThreadConnection();
+    };
+
+    DbConnectionPool();
+    ThreadConnection* threadConnection();
+    void release(Lease& lease);
+    void releaseReaderSlot();
+    bool takeSlotToRetire();
+    void recordLease(qint64 waitedMs, bool waited);
+
+    QThreadStorage<ThreadConnection*> connections;
+    QSemaphore readerSlots;
+    QRecursiveMutex writerMutex;  // re-entrant: a writer may call other writing helpers
+    mutable QMutex configMutex;
+
+    QString dbPath;
+    int maxReaders = 0;
+    std::atomic<int> slotsToRetire { 0 };   // reader slots to drop instead of release after a shrink
+    std::function<void(QSqlDatabase&)> onOpen;
+    std::atomic<quint64> generation { 1 };
+    std::atomic<quint64> nextConnectionId { 1 };
+    std::atomic<quint64> nextLeaseId { 1 };
+
+    mutable QMutex metricsMutex;
+    DbPoolMetrics stats;
+};
+
+using DbLease = DbConnectionPool::Lease;
+
+#endif // DBCONNECTIONPOOL_H
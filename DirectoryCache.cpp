@@ -0,0 +1,185 @@
+#include "DirectoryCache.h"
+#include "FaceDatabaseManager.h"
+#include "ScanPipeline.h"
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+
+constexpr quint32 LISTING_VERSION = 1;
+
+DirectoryCache& DirectoryCache::instance() {
+    static DirectoryCache inst;
+    return inst;
+}
+
+DirectoryCache::DirectoryCache() {
+    dbWrites.setMaxThreadCount(1);
+    dbWrites.setObjectName("DirectoryCache");
+}
+
+DirectoryEntry::Content DirectoryCache::probeFolder(const QString& dirPath) {
+    QDirIterator it(dirPath, QDir::Files | QDir::NoDotAndDotDot);
+    bool anyFile = false;
+    while (it.hasNext()) {
+        it.next();
+        anyFile = true;
+        if (ScanPipeline::isImageFile(it.fileName()))
+            return DirectoryEntry::ContentImages;
+    }
+    return anyFile ? DirectoryEntry::ContentOther : DirectoryEntry::ContentEmpty;
+}
+
+qint64 DirectoryCache::folderMtime(const QString& dirPath) {
+    return QFileInfo(dirPath).lastModified().toMSecsSinceEpoch();
+}
+
+// Names and types only: the type comes from the directory entry itself on
+// most file systems, so nothing here stats individual files
+DirectoryListing DirectoryCache::readFromDisk(const QString& dirPath) {
+    DirectoryListing listing;
+    listing.path = dirPath;
+    listing.dirMtime = folderMtime(dirPath);
+
+    QVector<QString> keys;
+    QDirIterator it(dirPath, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        DirectoryEntry e;
+        e.name = it.fileName();
+        e.isDir = it.fileInfo().isDir();
+        if (!e.isDir && !ScanPipeline::isImageFile(e.name))
+            continue;
+        listing.entries.append(std::move(e));
+    }
+
+    // ✅ Keys computed once per entry, not twice per comparison
+    QVector<int> order(listing.entries.size());
+    keys.reserve(listing.entries.size());
+    for (int i = 0; i < listing.entries.size(); ++i) {
+        order[i] = i;
+        keys.append(listing.entries[i].name.toCaseFolded());
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const DirectoryEntry& ea = listing.entries[a];
+        const DirectoryEntry& eb = listing.entries[b];
+        if (ea.isDir != eb.isDir) return ea.isDir;
+        return keys[a] < keys[b];
+    });
+
+    QVector<DirectoryEntry> sorted;
+    sorted.reserve(order.size());
+    for (int i : order)
+        sorted.append(std::move(listing.entries[i]));
+    listing.entries = std::move(sorted);
+    return listing;
+}
+
+DirectoryListing DirectoryCache::list(const QString& path, bool* fromCache) {
+    const QString dirPath = QDir::cleanPath(path);
+    const qint64 mtime = folderMtime(dirPath);  // the one stat a cached visit costs
+    if (fromCache) *fromCache = true;
+
+    {
+        QMutexLocker locker(&mutex);
+        auto it = listings.constFind(dirPath);
+        if (it != listings.constEnd() && it->dirMtime == mtime) {
+            recent.removeOne(dirPath);
+            recent.append(dirPath);
+            return it.value();
+        }
+    }
+
+    if (persistent) {
+        DirectoryListing stored;
+        if (deserialize(FaceDatabaseManager::instance().directoryListing(dirPath, mtime), stored)) {
+            stored.path = dirPath;
+            stored.dirMtime = mtime;
+            remember(stored);
+            return stored;
+        }
+    }
+
+    if (fromCache) *fromCache = false;
+    return readFromDisk(dirPath);
+}
+
+void DirectoryCache::store(DirectoryListing listing) {
+    listing.path = QDir::cleanPath(listing.path);
+
+    remember(listing);
+    if (persistent) {
+        QByteArray bytes = serialize(listing);
+        dbWrites.start([listing, bytes]() {
+            FaceDatabaseManager::instance().saveDirectoryListing(listing.path, listing.dirMtime, bytes);
+        });
+    }
+}
+
+void DirectoryCache::remember(const DirectoryListing& listing) {
+    QMutexLocker locker(&mutex);
+    listings.insert(listing.path, listing);
+    recent.removeOne(listing.path);
+    recent.append(listing.path);
+    while (recent.size() > maxFolders)
+        listings.remove(recent.takeFirst());
+}
+
+void DirectoryCache::invalidate(const QString& path) {
+    const QString dirPath = QDir::cleanPath(path);
+    {
+        QMutexLocker locker(&mutex);
+        listings.remove(dirPath);
+        recent.removeOne(dirPath);
+    }
+    if (persistent) {
+        // Queued behind any pending save of the same folder, so a stale listing cannot come back
+        dbWrites.start([dirPath]() {
+            FaceDatabaseManager::instance().dropDirectoryListing(dirPath);
+        });
+    }
+}
+
+void DirectoryCache::invalidateFiles(const QStringList& filePaths) {
+    QSet<QString> folders;
+    for (const QString& path : filePaths)
+        folders.insert(QFileInfo(path).absolutePath());
+    for (const QString& folder : folders)
+        invalidate(folder);
+}
+
+void DirectoryCache::setPersistent(bool enabled) {
+    persistent = enabled;
+}
+
+QByteArray DirectoryCache::serialize(const DirectoryListing& listing) {
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << LISTING_VERSION << qint32(listing.entries.size());
+    for (const DirectoryEntry& e : listing.entries)
+        out << e.name << e.isDir << e.mtime << e.content;
+    return bytes;
+}
+
+bool DirectoryCache::deserialize(const QByteArray& bytes, DirectoryListing& listing) {
+    if (bytes.isEmpty()) return false;
+
+    QDataStream in(bytes);
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> version >> count;
+    if (version != LISTING_VERSION || count < 0) return false;
+
+    listing.entries.clear();
+    listing.entries.reserve(count);
+    for (qint32 i = 0; i < count; ++i) {
+        DirectoryEntry e;
+        in >> e.name >> e.isDir >> e.mtime >> e.content;
+        listing.entries.append(std::move(e));
+    }
+    return in.status() == QDataStream::Ok;
+}
@@ -0,0 +1,82 @@
+#ifndef DIRECTORYCACHE_H
+#define DIRECTORYCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+
+struct DirectoryEntry {
+    enum Content : quint8 {
+        ContentUnknown,     // not probed yet
+        ContentImages,      // has at least one image file
+        ContentEmpty,       // no files at all (subfolders only, or nothing)
+        ContentOther        // files, but none of them images
+    };
+
+    QString name;
+    bool isDir = false;
+    qint64 mtime = 0;       // files: source mtime; folders: their own mtime when probed; 0 = unknown
+    quint8 content = ContentUnknown;    // folders only
+};
+
+// A folder's subfolders and image files, folders first, case-folded name order
+struct DirectoryListing {
+    QString path;
+    qint64 dirMtime = 0;    // the folder's own mtime when it was listed
+    QVector<DirectoryEntry> entries;
+};
+
+// Folder listings served from memory (or the database) while the folder's
+// own mtime is unchanged, so navigating slow storage costs one stat instead
+// of a directory read. Adding, removing or renaming entries bumps a folder's
+// mtime; edits inside a file do not, which is what the watch feed (library
+// roots) and an explicit refresh are for. Thread-safe, and nothing here
+// touches the database on the caller's thread except list(): persisting and
+// dropping listings run in order on one background thread.
+class DirectoryCache {
+public:
+    static DirectoryCache& instance();
+
+    // From memory, then the database, then the disk; `fromCache` tells which side answered
+    DirectoryListing list(const QString& dirPath, bool* fromCache = nullptr);
+
+    // Completed listing (file mtimes, subfolder probes filled in), kept and persisted.
+    // No stat here: the caller's workers check the folder's mtime still equals dirMtime.
+    void store(DirectoryListing listing);
+
+    void invalidate(const QString& dirPath);
+
+    // Drops the listings of the folders containing these files
+    void invalidateFiles(const QStringList& filePaths);
+
+    // Also keep listings in the database across runs (default: on)
+    void setPersistent(bool enabled);
+
+    // What a subfolder holds: one directory read, stopping at the first image
+    static DirectoryEntry::Content probeFolder(const QString& dirPath);
+
+    static qint64 folderMtime(const QString& dirPath);
+
+private:
+    DirectoryCache();
+
+    static DirectoryListing readFromDisk(const QString& dirPath);
+    static QByteArray serialize(const DirectoryListing& listing);
+    static bool deserialize(const QByteArray& bytes, DirectoryListing& listing);
+
+    void remember(const DirectoryListing& listing);
+
+    static constexpr int maxFolders = 64;
+
+    QMutex mutex;
+    QHash<QString, DirectoryListing> listings;
+    QStringList recent;     // most recently used last
+    std::atomic<bool> persistent { true };
+    QThreadPool dbWrites;   // one thread: saves and drops reach the database in call order
+};
+
+#endif // DIRECTORYCACHE_H
@@ -0,0 +1,484 @@
+#include "EmbeddingStore.h"
+#include "FaceDatabaseManager.h"
+
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+static const char STORE_MAGIC[8] = { 'P', 'X', 'E', 'M', 'B', 'E', 'D', '1' };
+constexpr quint32 STORE_VERSION = 2;   // 2: deleted flags column
+constexpr quint64 STORE_HEADER_SIZE = 4096;
+constexpr quint64 STORE_MIN_CAPACITY = 1024;
+constexpr int STORE_SYNC_BATCH = 4096;
+
+static bool flushToDisk(QFile& f) {
+    if (!f.flush()) return false;
+#ifdef Q_OS_WIN
+    return _commit(f.handle()) == 0;
+#else
+    return ::fsync(f.handle()) == 0;
+#endif
+}
+
+static bool replaceFile(const QString& from, const QString& to) {
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(from.utf16()), reinterpret_cast<LPCWSTR>(to.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+EmbeddingStore& EmbeddingStore::instance() {
+    static EmbeddingStore inst;
+    return inst;
+}
+
+EmbeddingStore::EmbeddingStore() {
+    path = FaceDatabaseManager::instance().databaseFilePath() + ".embeddings";
+    syncPool.setMaxThreadCount(1);
+    syncPool.setObjectName("EmbeddingStore");
+
+    // Cheap: map what is on disk. Anything that needs a rebuild waits for prepare()
+    QMutexLocker locker(&appendMutex);
+    if (QFileInfo::exists(path) && !openFile())
+        qWarning() << "⚠️ Embedding store needs a rebuild:" << path;
+}
+
+bool EmbeddingStore::prepare() {
+    QMutexLocker appendLocker(&appendMutex);
+    if (!mapped) {
+        // An empty database gets an empty store; otherwise copy every vector in one sized pass
+        const bool empty = FaceDatabaseManager::instance().faceRowCount() == 0;
+        if (!(empty ? createEmpty() : rebuildLocked())) {
+            qWarning() << "❌ Embedding store unavailable:" << path;
+            return false;
+        }
+    }
+    if (!catchUpLocked())
+        return false;
+
+    // Rows it cannot follow (a copy promoted to canonical once its original is deleted) leave the counts apart
+    const qint64 live = qint64(header.count - header.deletedCount);
+    const qint64 rows = FaceDatabaseManager::instance().faceRowCount();
+    if (live == rows)
+        return true;
+
+    qWarning() << "⚠️ Embedding store holds" << live << "live vector(s) for" << rows << "face row(s), rebuilding";
+    return rebuildLocked() && catchUpLocked();
+}
+
+EmbeddingStore::~EmbeddingStore() {
+    syncPool.clear();
+    syncPool.waitForDone();
+    QWriteLocker locker(&lock);
+    unmap();
+}
+
+quint64 EmbeddingStore::flagsOffsetFor(quint64 capacity) {
+    return STORE_HEADER_SIZE + capacity * sizeof(qint64);
+}
+
+quint64 EmbeddingStore::vectorsOffsetFor(quint64 capacity) {
+    quint64 end = flagsOffsetFor(capacity) + capacity;
+    return (end + STORE_HEADER_SIZE - 1) / STORE_HEADER_SIZE * STORE_HEADER_SIZE;
+}
+
+const qint64* EmbeddingStore::idColumn() const {
+    return reinterpret_cast<const qint64*>(mapped + header.idsOffset);
+}
+
+const uchar* EmbeddingStore::flagColumn() const {
+    return mapped + header.flagsOffset;
+}
+
+qint64 EmbeddingStore::rowOf(qint64 faceId) const {
+    if (!mapped || header.count == 0) return -1;
+    const qint64* ids = idColumn();
+    const qint64* end = ids + header.count;
+    const qint64* it = std::lower_bound(ids, end, faceId);
+    return (it == end || *it != faceId) ? -1 : qint64(it - ids);
+}
+
+const float* EmbeddingStore::vectorColumn() const {
+    return reinterpret_cast<const float*>(mapped + header.vectorsOffset);
+}
+
+bool EmbeddingStore::syncToDisk() {
+    return flushToDisk(file);
+}
+
+// Writes a complete store next to the live one, then swaps it in atomically.
+// `fill` writes rows into the new file and updates count/syncedId in the header.
+static bool writeStoreFile(const QString& target, void* headerPtr, size_t headerSize,
+                           quint64 fileSize, const std::function<bool(QFile&)>& fill) {
+    QString tmpPath = target + ".tmp";
+    QFile tmp(tmpPath);
+    if (!tmp.open(QIODevice::ReadWrite | QIODevice::Truncate) || !tmp.resize(fileSize)) {
+        qWarning() << "❌ Cannot create embedding store:" << tmpPath << tmp.errorString();
+        return false;
+    }
+
+    bool ok = fill(tmp);
+
+    // Header last: a torn write leaves the old store in place
+    QByteArray page(STORE_HEADER_SIZE, '\0');
+    std::memcpy(page.data(), headerPtr, headerSize);
+    ok = ok && tmp.seek(0) && tmp.write(page) == page.size() && flushToDisk(tmp);
+    tmp.close();
+
+    if (!ok) {
+        QFile::remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+bool EmbeddingStore::createEmpty() {
+    Header empty {};
+    std::memcpy(empty.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    empty.version = STORE_VERSION;
+    empty.headerSize = STORE_HEADER_SIZE;
+    empty.idsOffset = STORE_HEADER_SIZE;
+    empty.flagsOffset = flagsOffsetFor(0);
+    empty.vectorsOffset = vectorsOffsetFor(0);
+    if (!writeStoreFile(path, &empty, sizeof(empty), empty.vectorsOffset, [](QFile&) { return true; }))
+        return false;
+
+    QWriteLocker locker(&lock);
+    return swapIn();
+}
+
+bool EmbeddingStore::openFile() {
+    QWriteLocker locker(&lock);
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning() << "❌ Cannot open embedding store:" << path << file.errorString();
+        return false;
+    }
+
+    Header h {};
+    bool valid = file.read(reinterpret_cast<char*>(&h), sizeof(h)) == sizeof(h)
+                 && std::memcmp(h.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) == 0
+                 && h.version == STORE_VERSION && h.dtype == 0 && h.headerSize == STORE_HEADER_SIZE
+                 && h.count <= h.capacity && h.deletedCount <= h.count
+                 && h.flagsOffset == flagsOffsetFor(h.capacity) && h.vectorsOffset == vectorsOffsetFor(h.capacity);
+    if (!valid) {
+        qWarning() << "⚠️ Embedding store has an unknown format:" << path;
+        file.close();
+        return false;
+    }
+
+    // A crash after the swap but before the resize can leave the file short
+    quint64 expected = h.vectorsOffset + h.capacity * h.dim * sizeof(float);
+    if (static_cast<quint64>(file.size()) < expected)
+        file.resize(expected);
+
+    header = h;
+    return map();
+}
+
+bool EmbeddingStore::map() {
+    mapped = file.map(0, file.size());
+    if (!mapped) {
+        qWarning() << "❌ Cannot map embedding store:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void EmbeddingStore::unmap() {
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    file.close();
+}
+
+// Renames the finished .tmp over the store and maps whichever file is now in
+// place: the new one, or the untouched old one (and its header) if the rename failed.
+bool EmbeddingStore::swapIn() {
+    unmap();
+    const bool replaced = replaceFile(path + ".tmp", path);
+    if (!replaced) {
+        qWarning() << "❌ Cannot replace embedding store:" << path;
+        QFile::remove(path + ".tmp");
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) return false;
+    Header h {};
+    if (file.read(reinterpret_cast<char*>(&h), sizeof(h)) != sizeof(h)) {
+        file.close();
+        return false;
+    }
+    header = h;
+    return map() && replaced;
+}
+
+bool EmbeddingStore::grow(quint64 minCapacity) {
+    quint64 capacity = qMax<quint64>(STORE_MIN_CAPACITY, header.capacity);
+    while (capacity < minCapacity)
+        capacity *= 2;
+
+    Header next = header;
+    next.capacity = capacity;
+    next.flagsOffset = flagsOffsetFor(capacity);
+    next.vectorsOffset = vectorsOffsetFor(capacity);
+    quint64 rowBytes = quint64(header.dim) * sizeof(float);
+
+    // Copy straight out of the current mapping; it stays valid until the swap
+    bool ok = writeStoreFile(path, &next, sizeof(next), next.vectorsOffset + capacity * rowBytes, [&](QFile& out) {
+        if (header.count == 0) return true;
+        return out.seek(next.idsOffset)
+               && out.write(reinterpret_cast<const char*>(idColumn()), header.count * sizeof(qint64))
+                      == qint64(header.count * sizeof(qint64))
+               && out.seek(next.flagsOffset)
+               && out.write(reinterpret_cast<const char*>(flagColumn()), header.count) == qint64(header.count)
+               && out.seek(next.vectorsOffset)
+               && out.write(reinterpret_cast<const char*>(vectorColumn()), header.count * rowBytes)
+                      == qint64(header.count * rowBytes);
+    });
+    if (!ok) return false;
+
+    // A failed swap keeps the old capacity, so catchUp() stops instead of writing past it
+    QWriteLocker locker(&lock);
+    return swapIn();
+}
+
+bool EmbeddingStore::catchUp() {
+    QMutexLocker appendLocker(&appendMutex);
+    return catchUpLocked();
+}
+
+void EmbeddingStore::scheduleCatchUp() {
+    if (catchUpQueued.exchange(true)) return;   // the queued pass reads these rows too
+    syncPool.start([this]() {
+        catchUpQueued = false;
+        catchUp();
+    });
+}
+
+bool EmbeddingStore::catchUpLocked() {
+    if (!mapped) return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 appended = 0;
+    qint64 flagged = 0;
+    const bool ok = appendRows(appended) && applyTombstones(flagged);
+
+    if (appended > 0 || flagged > 0)
+        qDebug() << "🧮 Embedding store: appended" << appended << "vector(s), flagged" << flagged << "deleted, total"
+                 << header.count << "in" << timer.elapsed() << "ms";
+    return ok;
+}
+
+bool EmbeddingStore::appendRows(qint64& appended) {
+    FaceDatabaseManager& dbm = FaceDatabaseManager::instance();
+    while (true) {
+        QList<QPair<qint64, QByteArray>> rows = dbm.embeddingsAfter(header.syncedId, STORE_SYNC_BATCH);
+        if (rows.isEmpty()) break;
+
+        // The first vector fixes the dimension of an empty store
+        if (header.dim == 0) {
+            for (const auto& row : rows) {
+                if (!row.second.isEmpty() && row.second.size() % sizeof(float) == 0) {
+                    QWriteLocker locker(&lock);
+                    header.dim = row.second.size() / sizeof(float);
+                    break;
+                }
+            }
+        }
+
+        const qint64 rowBytes = qint64(header.dim) * sizeof(float);
+        QByteArray ids, vectors;
+        for (const auto& row : rows) {
+            if (rowBytes == 0 || row.second.size() != rowBytes) continue;
+            ids.append(reinterpret_cast<const char*>(&row.first), sizeof(qint64));
+            vectors.append(row.second);
+        }
+        quint64 n = ids.size() / sizeof(qint64);
+
+        if (n > 0 && header.count + n > header.capacity && !grow(header.count + n))
+            return false;
+
+        // ✅ 1) rows past `count`, flushed  2) header with the new count, flushed
+        bool ok = true;
+        if (n > 0) {
+            ok = file.seek(header.idsOffset + header.count * sizeof(qint64)) && file.write(ids) == ids.size()
+                 && file.seek(header.vectorsOffset + header.count * rowBytes) && file.write(vectors) == vectors.size()
+                 && syncToDisk();
+        }
+
+        Header next = header;
+        next.count += n;
+        next.syncedId = rows.last().first;
+        ok = ok && file.seek(0) && file.write(reinterpret_cast<const char*>(&next), sizeof(next)) == sizeof(next)
+             && syncToDisk();
+        if (!ok) {
+            qWarning() << "❌ Embedding store append failed:" << file.errorString();
+            return false;
+        }
+
+        QWriteLocker locker(&lock);
+        header = next;
+        appended += n;
+    }
+    return true;
+}
+
+bool EmbeddingStore::applyTombstones(qint64& flagged) {
+    FaceDatabaseManager& dbm = FaceDatabaseManager::instance();
+    const char deleted = 1;
+    while (true) {
+        QList<QPair<qint64, qint64>> dead = dbm.tombstonesAfter(header.syncedTombstone, STORE_SYNC_BATCH);
+        if (dead.isEmpty()) break;
+
+        // ✅ 1) flags, flushed  2) header with the new tombstone mark, flushed; re-flagging is harmless
+        bool ok = true;
+        quint64 n = 0;
+        for (const auto& tombstone : dead) {
+            const qint64 row = rowOf(tombstone.second);
+            if (row < 0 || flagColumn()[row]) continue;
+            ok = ok && file.seek(header.flagsOffset + row) && file.write(&deleted, 1) == 1;
+            ++n;
+        }
+        if (n > 0)
+            ok = ok && syncToDisk();
+
+        Header next = header;
+        next.deletedCount += n;
+        next.syncedTombstone = dead.last().first;
+        ok = ok && file.seek(0) && file.write(reinterpret_cast<const char*>(&next), sizeof(next)) == sizeof(next)
+             && syncToDisk();
+        if (!ok) {
+            qWarning() << "❌ Embedding store delete flags failed:" << file.errorString();
+            return false;
+        }
+
+        QWriteLocker locker(&lock);
+        header = next;
+        flagged += n;
+    }
+    return true;
+}
+
+bool EmbeddingStore::rebuild() {
+    QMutexLocker appendLocker(&appendMutex);
+    return rebuildLocked();
+}
+
+bool EmbeddingStore::rebuildLocked() {
+    QElapsedTimer timer;
+    timer.start();
+
+    FaceDatabaseManager& dbm = FaceDatabaseManager::instance();
+    qint64 live = dbm.faceRowCount();
+
+    // The dimension comes from the data; 0 until the first face exists
+    Header next {};
+    std::memcpy(next.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    next.version = STORE_VERSION;
+    next.headerSize = STORE_HEADER_SIZE;
+    QList<QPair<qint64, QByteArray>> first = dbm.embeddingsAfter(0, 1);
+    next.dim = first.isEmpty() ? 0 : first.first().second.size() / sizeof(float);
+    next.capacity = next.dim == 0 ? 0 : qMax<quint64>(STORE_MIN_CAPACITY, live + live / 4);
+    next.idsOffset = STORE_HEADER_SIZE;
+    next.flagsOffset = flagsOffsetFor(next.capacity);
+    next.vectorsOffset = vectorsOffsetFor(next.capacity);
+    const qint64 rowBytes = qint64(next.dim) * sizeof(float);
+
+    // Only live rows are copied: every tombstone up to here is already accounted for
+    next.syncedTombstone = dbm.latestTombstone();
+
+    bool ok = writeStoreFile(path, &next, sizeof(next), next.vectorsOffset + next.capacity * rowBytes, [&](QFile& out) {
+        while (true) {
+            QList<QPair<qint64, QByteArray>> rows = dbm.embeddingsAfter(next.syncedId, STORE_SYNC_BATCH);
+            if (rows.isEmpty()) return true;
+
+            for (const auto& row : rows) {
+                // Rows committed since the count was taken are left for catchUp()
+                if (next.count >= next.capacity) return true;
+                next.syncedId = row.first;
+                if (row.second.size() != rowBytes) continue;
+                if (!out.seek(next.idsOffset + next.count * sizeof(qint64))
+                    || out.write(reinterpret_cast<const char*>(&row.first), sizeof(qint64)) != sizeof(qint64)
+                    || !out.seek(next.vectorsOffset + next.count * rowBytes)
+                    || out.write(row.second) != rowBytes)
+                    return false;
+                ++next.count;
+            }
+        }
+    });
+    if (!ok) return false;
+
+    {
+        QWriteLocker locker(&lock);
+        if (!swapIn()) return false;
+    }
+    dbm.trimTombstones(header.syncedTombstone);
+
+    qDebug() << "🧮 Embedding store rebuilt:" << header.count << "vector(s) in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool EmbeddingStore::compactIfSparse() {
+    qint64 live = FaceDatabaseManager::instance().faceRowCount();
+    if (size() <= 2 * live + qint64(STORE_MIN_CAPACITY))
+        return false;
+    return rebuild();
+}
+
+qint64 EmbeddingStore::size() const {
+    QReadLocker locker(&lock);
+    return mapped ? qint64(header.count) : 0;
+}
+
+int EmbeddingStore::dimension() const {
+    QReadLocker locker(&lock);
+    return int(header.dim);
+}
+
+int EmbeddingStore::visit(const QList<qint64>& faceIds,
+                          const std::function<void(int index, const EmbeddingView& embedding)>& fn) const {
+    QReadLocker locker(&lock);
+    int hits = 0;
+    for (int i = 0; i < faceIds.size(); ++i) {
+        const qint64 row = rowOf(faceIds[i]);
+        if (row < 0 || flagColumn()[row]) continue;
+        fn(i, EmbeddingView { vectorColumn() + row * header.dim, header.dim });
+        ++hits;
+    }
+    return hits;
+}
+
+void EmbeddingStore::forEach(const std::function<bool(qint64 faceId, const EmbeddingView& embedding)>& fn) const {
+    QReadLocker locker(&lock);
+    if (!mapped) return;
+    const qint64* ids = idColumn();
+    const uchar* flags = flagColumn();
+    const float* vectors = vectorColumn();
+    for (quint64 row = 0; row < header.count; ++row) {
+        if (flags[row]) continue;
+        if (!fn(ids[row], EmbeddingView { vectors + row * header.dim, header.dim }))
+            return;
+    }
+}
+
+bool EmbeddingStore::embedding(qint64 faceId, std::vector<float>& out) const {
+    return visit({ faceId }, [&out](int, const EmbeddingView& embedding) {
+        out = embedding.toVector();
+    }) > 0;
+}
@@ -0,0 +1,123 @@
+#ifndef EMBEDDINGSTORE_H
+#define EMBEDDINGSTORE_H
+
+#include <QString>
+#include <QFile>
+#include <QList>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "FaceTypes.h"
+
+// Append-only, memory-mapped mirror of face_embeddings.embedding.
+//
+// File layout (little endian):
+//   [0, 4096)                header (magic, version, dim, dtype, capacity, count, offsets,
+//                            syncedId, deletedCount, syncedTombstone)
+//   [idsOffset, ...)         capacity x int64 face ids, ascending
+//   [flagsOffset, ...)       capacity x uint8, 1 = deleted from SQLite
+//   [vectorsOffset, ...)     capacity x dim float32, 4 KiB aligned
+//
+// Append protocol: ids and vectors beyond `count` (or deleted flags) are
+// written and flushed to disk first, then the header (count, syncedId,
+// syncedTombstone) is rewritten and flushed. Readers only trust [0, count),
+// so a crash at any point leaves a valid store that simply lags SQLite;
+// catchUp() copies every row with id > syncedId and flags every face_tombstones
+// entry past syncedTombstone (a trigger fills that table on delete).
+// Growing the capacity or dropping deleted rows writes a complete new file
+// next to the store and renames it over the old one; if the rename fails the
+// old file and header stay in use.
+//
+// Reads never touch SQLite: deleted rows are skipped via their flag, which
+// trails the deleting commit by one catch-up pass. The writer only schedules
+// that pass (scheduleCatchUp()); it runs on the store's own thread, so its
+// fsyncs and any rebuild never hold up a group commit.
+//
+// instance() only opens an existing, valid file. Creating or rebuilding the
+// store reads every embedding and is left to prepare(), which startup runs
+// in the background; until then lookups miss and catchUp() does nothing.
+class EmbeddingStore {
+public:
+    static EmbeddingStore& instance();
+
+    // Rebuilds a missing or unreadable store from SQLite, then catches up. Slow: never on the GUI thread.
+    bool prepare();
+
+    // Appends every face row committed since the last sync and flags deleted ones
+    bool catchUp();
+    // Runs catchUp() on the store's thread; calls while one is queued fold into it
+    void scheduleCatchUp();
+
+    // Rewrites the store from SQLite when it holds many more rows than the table
+    bool compactIfSparse();
+    bool rebuild();
+
+    qint64 size() const;
+    int dimension() const;
+
+    // Zero-copy reads straight from the mapped columns. The callback runs under
+    // the read lock and its views are only valid inside it: keep it short and
+    // never call back into the store. Unmirrored and deleted ids are skipped.
+
+    // The given ids (binary search each); `index` is the position in faceIds. Returns the hits.
+    int visit(const QList<qint64>& faceIds, const std::function<void(int index, const EmbeddingView& embedding)>& fn) const;
+    // Every live row in id order; return false to stop
+    void forEach(const std::function<bool(qint64 faceId, const EmbeddingView& embedding)>& fn) const;
+
+    // Copies one vector; false if the id is not mirrored or was deleted
+    bool embedding(qint64 faceId, std::vector<float>& out) const;
+
+private:
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 dim;
+        quint32 dtype;          // 0 = float32
+        quint32 headerSize;
+        quint64 capacity;
+        quint64 count;
+        quint64 idsOffset;
+        quint64 vectorsOffset;
+        qint64 syncedId;        // highest face id examined (rows with bad blobs are skipped)
+        quint64 flagsOffset;
+        quint64 deletedCount;
+        qint64 syncedTombstone; // highest face_tombstones.seq applied
+    };
+
+    EmbeddingStore();
+    ~EmbeddingStore();
+
+    bool openFile();
+    bool createEmpty();
+    bool swapIn();
+    bool map();
+    void unmap();
+    bool grow(quint64 minCapacity);
+    bool rebuildLocked();
+    bool catchUpLocked();
+    bool appendRows(qint64& appended);
+    bool applyTombstones(qint64& flagged);
+    bool syncToDisk();
+
+    const qint64* idColumn() const;
+    const uchar* flagColumn() const;
+    const float* vectorColumn() const;
+    qint64 rowOf(qint64 faceId) const;      // -1 if not mirrored
+    static quint64 flagsOffsetFor(quint64 capacity);
+    static quint64 vectorsOffsetFor(quint64 capacity);
+
+    QString path;
+    QFile file;
+    uchar* mapped = nullptr;
+    Header header {};
+
+    mutable QReadWriteLock lock;    // readers vs. remap/header updates
+    QMutex appendMutex;             // one appender at a time
+    QThreadPool syncPool;           // one thread for scheduled catch-ups
+    std::atomic_bool catchUpQueued = false;
+};
+
+#endif // EMBEDDINGSTORE_H
@@ -0,0 +1,186 @@
+#include "FaceCropStore.h"
+#include "FaceDatabaseManager.h"
+#include "ScanPipeline.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+#include <opencv2/imgcodecs.hpp>
+
+static const char PACK_MAGIC[8] = { 'P', 'X', 'C', 'R', 'O', 'P', 'S', '1' };
+constexpr quint32 RECORD_MAGIC = 0x31464350;  // "PCF1"
+constexpr int RECORD_HEADER = 8;
+
+FaceCropStore& FaceCropStore::instance() {
+    static FaceCropStore inst;
+    return inst;
+}
+
+FaceCropStore::FaceCropStore() {
+    path = FaceDatabaseManager::instance().databaseFilePath() + ".crops";
+    QMutexLocker locker(&mutex);
+    openPack();
+}
+
+bool FaceCropStore::openPack() {
+    pack.setFileName(path);
+    if (!pack.open(QIODevice::ReadWrite)) {
+        qWarning() << "❌ Cannot open face crop pack:" << path << pack.errorString();
+        return false;
+    }
+
+    if (pack.size() == 0) {
+        pack.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+        pack.flush();
+    } else {
+        QByteArray magic = pack.read(sizeof(PACK_MAGIC));
+        if (magic != QByteArray(PACK_MAGIC, sizeof(PACK_MAGIC))) {
+            qWarning() << "❌ Not a face crop pack:" << path;
+            pack.close();
+            return false;
+        }
+    }
+    packEnd = pack.size();
+    return true;
+}
+
+QByteArray FaceCropStore::encode(const QImage& crop) {
+    QByteArray bytes;
+    if (crop.isNull()) return bytes;
+
+    QImage scaled = crop.size() == QSize(cropSize, cropSize)
+                        ? crop
+                        : crop.scaled(cropSize, cropSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    scaled.save(&buffer, "JPG", 90);
+    return bytes;
+}
+
+qint64 FaceCropStore::append(const QByteArray& encoded) {
+    if (encoded.isEmpty()) return -1;
+
+    QMutexLocker locker(&mutex);
+    if (!pack.isOpen()) return -1;
+
+    qint64 offset = packEnd + pending.size();
+    uchar header[RECORD_HEADER];
+    qToLittleEndian<quint32>(RECORD_MAGIC, header);
+    qToLittleEndian<quint32>(static_cast<quint32>(encoded.size()), header + 4);
+    pending.append(reinterpret_cast<const char*>(header), RECORD_HEADER);
+    pending.append(encoded);
+    return offset;
+}
+
+bool FaceCropStore::flush() {
+    QMutexLocker locker(&mutex);
+    if (pending.isEmpty()) return true;
+    if (!pack.isOpen()) return false;
+
+    // Records buffered by other callers go out too; offsets were handed out in buffer order
+    if (!pack.seek(packEnd) || pack.write(pending) != pending.size() || !pack.flush()) {
+        qWarning() << "❌ Face crop append failed:" << pack.errorString();
+        pack.resize(packEnd);  // kept buffered: the offsets are spoken for, the next flush retries
+        return false;
+    }
+    packEnd += pending.size();
+    pending.clear();
+    return true;
+}
+
+QByteArray FaceCropStore::readRecord(qint64 offset, int size) {
+    uchar header[RECORD_HEADER];
+    if (!pack.seek(offset) || pack.read(reinterpret_cast<char*>(header), RECORD_HEADER) != RECORD_HEADER)
+        return QByteArray();
+
+    // A record that did not fully reach the disk reads as missing and is regenerated
+    if (qFromLittleEndian<quint32>(header) != RECORD_MAGIC || int(qFromLittleEndian<quint32>(header + 4)) != size)
+        return QByteArray();
+
+    QByteArray bytes = pack.read(size);
+    return bytes.size() == size ? bytes : QByteArray();
+}
+
+QImage FaceCropStore::cropFromSource(const FaceCropRequest& face) {
+    // Decoded exactly like detection: cv::imread applies the EXIF orientation, and stored
+    // rects are in the resized detection image, mapped back with the same scale.
+    // Rows without a stored crop predate the crop pack and come from GUI scans (default options).
+    cv::Mat full = cv::imread(face.imagePath.toStdString());
+    if (full.empty()) return QImage();
+
+    cv::Rect roi(0, 0, full.cols, full.rows);
+    if (face.faceRect.isValid()) {
+        const QSizeF scale = detectionScale(QSize(full.cols, full.rows), ScanOptions().resizeMode);
+        roi = cv::Rect(int(face.faceRect.x() * scale.width()), int(face.faceRect.y() * scale.height()),
+                       int(face.faceRect.width() * scale.width()), int(face.faceRect.height() * scale.height()));
+        roi &= cv::Rect(0, 0, full.cols, full.rows);
+        if (roi.empty()) return QImage();
+    }
+
+    cv::Mat faceMat = full(roi);
+    QImage image(faceMat.data, faceMat.cols, faceMat.rows, faceMat.step, QImage::Format_BGR888);
+    return image.scaled(cropSize, cropSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+QHash<qint64, QImage> FaceCropStore::load(const QList<FaceCropRequest>& faces, qint64* bytesRead) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<qint64, QImage> crops;
+    qint64 bytes = 0;
+    if (bytesRead) *bytesRead = 0;
+    if (faces.isEmpty()) return crops;
+
+    FaceDatabaseManager& db = FaceDatabaseManager::instance();
+    QList<qint64> ids;
+    for (const FaceCropRequest& face : faces)
+        ids << face.faceId;
+    QHash<qint64, QPair<qint64, int>> locations = db.faceCropLocations(ids);
+
+    // ✅ Read in pack order: one forward pass over the file
+    QList<QPair<qint64, qint64>> byOffset;  // offset, face id
+    for (auto it = locations.cbegin(); it != locations.cend(); ++it)
+        byOffset.append({ it.value().first, it.key() });
+    std::sort(byOffset.begin(), byOffset.end());
+
+    {
+        QMutexLocker locker(&mutex);
+        if (pack.isOpen()) {
+            for (const auto& entry : byOffset) {
+                QByteArray record = readRecord(entry.first, locations.value(entry.second).second);
+                bytes += record.size();
+                QImage image = QImage::fromData(record, "JPG");
+                if (!image.isNull())
+                    crops.insert(entry.second, image);
+            }
+        }
+    }
+    int fromPack = crops.size();
+
+    // Older rows: cut from the source once, then keep
+    QList<QPair<qint64, QPair<qint64, int>>> generated;
+    for (const FaceCropRequest& face : faces) {
+        if (crops.contains(face.faceId)) continue;
+
+        QImage image = cropFromSource(face);
+        bytes += QFileInfo(face.imagePath).size();
+        if (image.isNull()) continue;
+        crops.insert(face.faceId, image);
+
+        QByteArray encoded = encode(image);
+        qint64 offset = append(encoded);
+        if (offset >= 0)
+            generated.append({ face.faceId, { offset, static_cast<int>(encoded.size()) } });
+    }
+    if (!generated.isEmpty() && flush())
+        db.addFaceCropLocations(generated);
+
+    if (bytesRead) *bytesRead = bytes;
+    qDebug() << "🖼️ Face crops:" << fromPack << "from pack," << generated.size() << "generated in"
+             << timer.elapsed() << "ms";
+    return crops;
+}
@@ -0,0 +1,64 @@
+#ifndef FACECROPSTORE_H
+#define FACECROPSTORE_H
+
+#include <QString>
+#include <QFile>
+#include <QMutex>
+#include <QImage>
+#include <QHash>
+#include <QList>
+#include <QRect>
+#include <QByteArray>
+
+// A face whose crop is wanted; source + rect are used if no crop was stored yet
+struct FaceCropRequest {
+    qint64 faceId = 0;
+    QString imagePath;
+    QRect faceRect;
+};
+
+// Packed store of small face crops (JPEG) next to the database, in <db>.crops.
+// The pack is append-only: [magic u32][size u32][bytes] per record. The
+// face_crops table maps face ids to record offsets and is written in the same
+// transaction as the faces, so clones can share one record. Bytes left behind
+// by deleted or rolled-back faces are garbage, never referenced again.
+//
+// append() only buffers: records reach the file in one write on flush(),
+// which the writer calls once per group commit, before committing the rows
+// that point at them.
+class FaceCropStore {
+public:
+    static constexpr int cropSize = 64;
+
+    static FaceCropStore& instance();
+
+    // Encodes a crop the way the store keeps it
+    static QByteArray encode(const QImage& crop);
+
+    // Buffers one encoded crop; returns the offset it will have, or -1
+    qint64 append(const QByteArray& encoded);
+
+    // Writes every buffered record; false if the pack could not be written
+    bool flush();
+
+    // Crops for the given faces, read in pack order. Faces without a stored
+    // crop (older rows) are cut from their source image once and stored.
+    // That decodes photos: callers (face list loader, prefetcher) run it on worker threads.
+    // `bytesRead` receives the pack bytes plus the size of every photo decoded.
+    QHash<qint64, QImage> load(const QList<FaceCropRequest>& faces, qint64* bytesRead = nullptr);
+
+private:
+    FaceCropStore();
+
+    bool openPack();
+    QByteArray readRecord(qint64 offset, int size);
+    static QImage cropFromSource(const FaceCropRequest& face);
+
+    QString path;
+    QFile pack;
+    qint64 packEnd = 0;         // file size without the buffered records
+    QByteArray pending;         // records appended since the last flush
+    QMutex mutex;
+};
+
+#endif // FACECROPSTORE_H
@@ -5,15 +5,48 @@
 #include <QVariant>
 #include <QSqlRecord>
 #include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QCoreApplication>
 #include <QThread>
+#include <QHash>
+#include <QElapsedTimer>
 #include "embeddingUtils.h"
+#include "ImageFingerprint.h"
+#include "EmbeddingStore.h"
+#include "FolderSummaryIndex.h"
+#include "FaceCropStore.h"
+
+static QString& databasePathOverride() {
+    static QString path;
+    return path;
+}
+
+void FaceDatabaseManager::setDatabasePath(const QString& dbPath) {
+    databasePathOverride() = dbPath;
+}
+
+static SqliteProfile& initialProfile() {
+    static SqliteProfile profile;
+    return profile;
+}
+
+void FaceDatabaseManager::setInitialConnectionProfile(const SqliteProfile& p) {
+    initialProfile() = p;
+}
 
 FaceDatabaseManager::FaceDatabaseManager() {
+    profile = initialProfile();
+
     QString appPath = QCoreApplication::applicationDirPath();
     QString cacheDirPath = appPath + "/.cache";
     QString dbPath = cacheDirPath + "/face_database.sqlite";
 
+    if (!databasePathOverride().isEmpty()) {
+        dbPath = QFileInfo(databasePathOverride()).absoluteFilePath();
+        cacheDirPath = QFileInfo(dbPath).absolutePath();
+    }
+
     // ✅ Create .cache directory if it doesn't exist
     QDir cacheDir(cacheDirPath);
     if (!cacheDir.exists()) {
@@ -23,12 +56,13 @@ FaceDatabaseManager::FaceDatabaseManager() {
         }
     }
 
-    // ✅ Initialize database connection
-    db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName(dbPath);
+    // ✅ All connections come from the managed pool
+    dbFilePath = dbPath;
+    configurePool();
 
-    if (!db.open()) {
-        qCritical() << "❌ Failed to open SQLite database:" << db.lastError().text();
+    DbLease lease = DbConnectionPool::instance().writer();
+    if (!lease.isValid()) {
+        qCritical() << "❌ Failed to open SQLite database:" << lease.database().lastError().text();
         return;
     }
 
@@ -37,18 +71,72 @@ FaceDatabaseManager::FaceDatabaseManager() {
 }
 
 bool FaceDatabaseManager::open(const QString& dbPath) {
-    db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName(dbPath);
-    if (!db.open()) {
-        qWarning() << "❌ Failed to open DB:" << db.lastError().text();
+    dbFilePath = dbPath;
+    configurePool();
+
+    DbLease lease = DbConnectionPool::instance().writer();
+    if (!lease.isValid()) {
+        qWarning() << "❌ Failed to open DB:" << lease.database().lastError().text();
         return false;
     }
     ensureTables();
     return true;
 }
 
+void FaceDatabaseManager::configurePool() {
+    SqliteProfile p = connectionProfile();
+    int readers = p.maxReaderConnections > 0 ? p.maxReaderConnections : qMax(2, QThread::idealThreadCount());
+    DbConnectionPool::instance().configure(dbFilePath, readers, [this](QSqlDatabase& conn) {
+        applyConnectionProfile(conn);
+    });
+}
+
+void FaceDatabaseManager::setConnectionProfile(const SqliteProfile& p) {
+    {
+        QMutexLocker locker(&profileMutex);
+        profile = p;
+    }
+    if (!dbFilePath.isEmpty())
+        configurePool();
+}
+
+DbPoolMetrics FaceDatabaseManager::connectionMetrics() const {
+    return DbConnectionPool::instance().metrics();
+}
+
+SqliteProfile FaceDatabaseManager::connectionProfile() const {
+    QMutexLocker locker(&profileMutex);
+    return profile;
+}
+
+void FaceDatabaseManager::applyConnectionProfile(QSqlDatabase& conn) {
+    SqliteProfile p = connectionProfile();
+    QSqlQuery q(conn);
+
+    q.exec(QString("PRAGMA busy_timeout = %1").arg(p.busyTimeoutMs));
+
+    // journal_mode is stored in the file: a database once opened tuned stays WAL unless switched back
+    if (!p.tuned) {
+        if (q.exec("PRAGMA journal_mode = DELETE") && q.next() && q.value(0).toString() != "delete") {
+            qWarning() << "⚠️ Could not leave WAL (other connections open?), journal mode is:" << q.value(0).toString();
+        }
+        q.exec("PRAGMA synchronous = FULL");
+        return;
+    }
+
+    // ✅ WAL lets readers run alongside the writer; NORMAL only syncs at checkpoints
+    if (q.exec("PRAGMA journal_mode = WAL") && q.next() && q.value(0).toString() != "wal") {
+        qWarning() << "⚠️ WAL not available, journal mode is:" << q.value(0).toString();
+    }
+    q.exec("PRAGMA synchronous = NORMAL");
+    q.exec(QString("PRAGMA cache_size = -%1").arg(p.cacheSizeKiB));
+    q.exec(QString("PRAGMA mmap_size = %1").arg(p.mmapSizeBytes));
+    q.exec("PRAGMA temp_store = MEMORY");
+}
+
 void FaceDatabaseManager::ensureTables() {
-    QSqlQuery q(getThreadDb());
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery q(lease.database());
 
     q.exec(R"(
         CREATE TABLE IF NOT EXISTS face_embeddings (
@@ -79,18 +167,144 @@ void FaceDatabaseManager::ensureTables() {
         )
     )");
 
+    // One row per analysed file (even with zero faces); content_hash finds copies
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS images (
+            image_path TEXT PRIMARY KEY,
+            mtime INTEGER,
+            file_size INTEGER,
+            content_hash TEXT,
+            full_hash TEXT,
+            face_count INTEGER
+        )
+    )");
+
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS library_roots (
+            root_path TEXT PRIMARY KEY
+        )
+    )");
+
+    // ✅ Folder listings kept across runs, for slow (network) storage
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS directory_listings (
+            dir_path TEXT PRIMARY KEY,
+            dir_mtime INTEGER,
+            listing BLOB
+        )
+    )");
+
+    // ✅ Per folder and identity: direct/subtree face counts and best exemplars
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS folder_person_summary (
+            folder_path TEXT,
+            global_id TEXT,
+            direct_count INTEGER DEFAULT 0,
+            subtree_count INTEGER DEFAULT 0,
+            direct_best_id INTEGER,
+            direct_best_quality REAL,
+            subtree_best_id INTEGER,
+            subtree_best_quality REAL,
+            PRIMARY KEY (folder_path, global_id)
+        )
+    )");
+
+    // ✅ Where each face's crop sits in the crop pack (see FaceCropStore)
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS face_crops (
+            face_id INTEGER PRIMARY KEY,
+            pack_offset INTEGER,
+            byte_size INTEGER
+        )
+    )");
+
+    // ✅ Resumable scans: the job, its directory frontier and its numbered file list
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS scan_jobs (
+            job_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            roots TEXT,
+            options TEXT,
+            state TEXT,
+            file_count INTEGER DEFAULT 0,
+            watermark INTEGER DEFAULT 0,
+            created_at INTEGER,
+            updated_at INTEGER
+        )
+    )");
+
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS scan_job_dirs (
+            job_id INTEGER,
+            dir_path TEXT,
+            done INTEGER DEFAULT 0,
+            PRIMARY KEY (job_id, dir_path)
+        )
+    )");
+
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS scan_job_files (
+            job_id INTEGER,
+            seq INTEGER,
+            path TEXT,
+            PRIMARY KEY (job_id, seq)
+        )
+    )");
+
     // ✅ Add these indexes to speed up WHERE queries
     q.exec(R"(CREATE INDEX IF NOT EXISTS idx_face_mtime ON face_embeddings(image_path, mtime))");
     q.exec(R"(CREATE INDEX IF NOT EXISTS idx_face_globalid ON face_embeddings(global_id))");
     q.exec(R"(CREATE INDEX IF NOT EXISTS idx_face_folder ON face_embeddings(image_path))");
+    q.exec(R"(CREATE INDEX IF NOT EXISTS idx_images_hash ON images(content_hash))");
+
+    QSqlDatabase conn = lease.database();
+    addColumnIfMissing(conn, "images", "file_id", "TEXT");
+    q.exec(R"(CREATE INDEX IF NOT EXISTS idx_images_fileid ON images(file_id))");
+
+    // Roots scanned without subfolders are watched without them too
+    addColumnIfMissing(conn, "library_roots", "recursive", "INTEGER DEFAULT 1");
+
+    // ✅ Faces copied from an identical file point at the canonical row and are not counted twice
+    addColumnIfMissing(conn, "face_embeddings", "clone_of", "INTEGER");
+    q.exec(R"(CREATE INDEX IF NOT EXISTS idx_face_cloneof ON face_embeddings(clone_of))");
+
+    // ✅ Deleted vectors for EmbeddingStore, written in the deleting transaction whichever code path deletes
+    q.exec(R"(
+        CREATE TABLE IF NOT EXISTS face_tombstones (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            face_id INTEGER
+        )
+    )");
+    q.exec(R"(
+        CREATE TRIGGER IF NOT EXISTS trg_face_tombstone AFTER DELETE ON face_embeddings
+        WHEN old.clone_of IS NULL
+        BEGIN
+            INSERT INTO face_tombstones (face_id) VALUES (old.id);
+        END
+    )");
+}
+
+void FaceDatabaseManager::addColumnIfMissing(QSqlDatabase& conn, const QString& table,
+                                             const QString& column, const QString& type) {
+    QSqlQuery info(conn);
+    if (info.exec(QString("PRAGMA table_info(%1)").arg(table))) {
+        while (info.next()) {
+            if (info.value(1).toString() == column)
+                return;
+        }
+    }
+
+    QSqlQuery alter(conn);
+    if (!alter.exec(QString("ALTER TABLE %1 ADD COLUMN %2 %3").arg(table, column, type))) {
+        qWarning() << "❌ Failed to add column" << table << column << alter.lastError().text();
+    }
 }
 
 
 bool FaceDatabaseManager::addFace(const QString& imagePath, const QRect& rect,
                                   const std::vector<float>& embedding, float quality, qint64 mtime)
 {
-    QSqlQuery q(FaceDatabaseManager::getThreadDb());
-    q.prepare(R"(
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery& q = lease.prepared(R"(
         INSERT INTO face_embeddings (image_path, face_rect, embedding, global_id, quality, mtime)
         VALUES (?, ?, ?, ?, ?, ?)
     )");
@@ -105,25 +319,40 @@ bool FaceDatabaseManager::addFace(const QString& imagePath, const QRect& rect,
         qWarning() << "❌ Failed to insert face:" << q.lastError().text();
         return false;
     }
+    ++faceDataVersion;
     return true;
 }
 
 bool FaceDatabaseManager::faceAlreadyProcessed(const QString& imagePath, qint64 mtime)
 {
-    QSqlQuery q(FaceDatabaseManager::getThreadDb());
-    q.prepare("SELECT COUNT(*) FROM face_embeddings WHERE image_path = ? AND mtime = ?");
+    DbLease lease = DbConnectionPool::instance().reader();
+    bool processed = false;
+
+    // images covers files without faces; face_embeddings covers rows from older versions
+    QSqlQuery& img = lease.prepared("SELECT COUNT(*) FROM images WHERE image_path = ? AND mtime = ?");
+    img.addBindValue(imagePath);
+    img.addBindValue(mtime);
+    if (img.exec() && img.next()) {
+        processed = img.value(0).toInt() > 0;
+    }
+    img.finish();
+    if (processed) return true;
+
+    QSqlQuery& q = lease.prepared("SELECT COUNT(*) FROM face_embeddings WHERE image_path = ? AND mtime = ?");
     q.addBindValue(imagePath);
     q.addBindValue(mtime);
     if (q.exec() && q.next()) {
-        return q.value(0).toInt() > 0;
+        processed = q.value(0).toInt() > 0;
     }
-    return false;
+    q.finish();
+    return processed;
 }
 
 QList<FaceEntry> FaceDatabaseManager::getFacesForFolder(const QString& folderPath)
 {
     QList<FaceEntry> list;
-    QSqlQuery q(FaceDatabaseManager::getThreadDb());
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery q(lease.database());
     QString pathPrefix = folderPath.endsWith("/") ? folderPath : folderPath + "/";
     q.prepare("SELECT id, image_path, face_rect, global_id, quality FROM face_embeddings WHERE image_path LIKE ?");
     q.addBindValue(pathPrefix + "%");
@@ -148,7 +377,8 @@ QList<FaceEntry> FaceDatabaseManager::getFacesForFolder(const QString& folderPat
 QList<FaceEntry> FaceDatabaseManager::getFacesByGlobalId(const QString& globalId)
 {
     QList<FaceEntry> list;
-    QSqlQuery q(FaceDatabaseManager::getThreadDb());
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery q(lease.database());
     q.prepare("SELECT id, image_path, face_rect, quality FROM face_embeddings WHERE global_id = ?");
     q.addBindValue(globalId);
 
@@ -184,12 +414,14 @@ std::vector<float> FaceDatabaseManager::blobToEmbedding(const QByteArray& blob)
     return result;
 }
 
-std::vector<float> FaceDatabaseManager::getEmbeddingById(int id) {
+std::vector<float> FaceDatabaseManager::getEmbeddingById(qint64 id) {
+    // ✅ Mapped store first: no SQLite at all; deleted rows are flagged there
     std::vector<float> embedding;
+    if (EmbeddingStore::instance().embedding(id, embedding))
+        return embedding;
 
-    QSqlQuery query(getThreadDb());
-
-    query.prepare("SELECT embedding FROM face_embeddings WHERE id = ?");
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& query = lease.prepared("SELECT embedding FROM face_embeddings WHERE id = ?");
     query.addBindValue(id);
 
     if (query.exec() && query.next()) {
@@ -198,43 +430,18 @@ std::vector<float> FaceDatabaseManager::getEmbeddingById(int id) {
     } else {
         qWarning() << "⚠️ Failed to fetch embedding for ID:" << id << query.lastError().text();
     }
+    query.finish();
 
     return embedding;
 }
 
 QString FaceDatabaseManager::assignOrFindGlobalID(const std::vector<float>& embedding) {
-    QByteArray embBlob = embeddingToBlob(embedding);
-    QString matchedId;
-
-    QSqlQuery query(getThreadDb());
-    query.prepare("SELECT global_id, avg_embedding FROM global_faces");
-    if (query.exec()) {
-        while (query.next()) {
-            int existingId = query.value(0).toInt();
-            QByteArray existingBlob = query.value(1).toByteArray();
-            std::vector<float> existingEmb = blobToEmbedding(existingBlob);
-
-            // Compare with cosine similarity or L2 distance
-            float dist = l2Distance(embedding, existingEmb);
-            if (dist < 0.5f) {
-                matchedId = QString::number(existingId);
-                break;
-            }
-        }
-    }
-
-    if (matchedId.isEmpty()) {
-        // Generate new ID (or insert row to get ID)
-        QSqlQuery insert(getThreadDb());
-        insert.prepare("INSERT INTO global_faces (avg_embedding) VALUES (?)");
-        insert.addBindValue(embBlob);
-        if (insert.exec()) {
-            matchedId = QString::number(insert.lastInsertId().toInt());
-        } else {
-            qWarning() << "❌ Failed to insert global face ID:" << insert.lastError().text();
-        }
-    }
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
 
+    QString matchedId = identities.assign(db, embedding);
+    if (!identities.flush(db))
+        identities.invalidate();
     return matchedId;
 }
 
@@ -243,23 +450,10 @@ FaceDatabaseManager& FaceDatabaseManager::instance() {
     return inst;
 }
 
-QSqlDatabase FaceDatabaseManager::getThreadDb() {
-    QString connName = QString("face_db_%1").arg(reinterpret_cast<quintptr>(QThread::currentThread()));
-    if (!QSqlDatabase::contains(connName)) {
-        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connName);
-        db.setDatabaseName(QCoreApplication::applicationDirPath() + "/.cache/face_database.sqlite");
-        if (!db.open()) {
-            qWarning() << "❌ Failed to open SQLite DB in thread:" << db.lastError().text();
-        } else {
-            qDebug() << "✅ Opened thread-safe DB for:" << connName;
-        }
-    }
-    return QSqlDatabase::database(connName);
-}
-
 QList<FaceEntry> FaceDatabaseManager::getFaceEntriesInFolder(const QString& folderPath) {
     QList<FaceEntry> result;
-    QSqlQuery query(db);
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery query(lease.database());
 
     QString modPath = folderPath;
     modPath.replace("\\", "/");
@@ -298,7 +492,8 @@ QList<FaceEntry> FaceDatabaseManager::getFaceEntriesInFolder(const QString& fold
 
 QList<FaceEntry> FaceDatabaseManager::getFaceEntriesInSubtree(const QString& rootPath) {
     QList<FaceEntry> result;
-    QSqlQuery query(db);
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery query(lease.database());
 
     QString modPath = rootPath;
     modPath.replace("\\", "/");
@@ -340,14 +535,14 @@ bool FaceDatabaseManager::addFacesBatch(const QList<FaceEntry>& entries, const Q
         return false;
     }
 
-    QSqlDatabase db = getThreadDb();
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
     if (!db.transaction()) {
         qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
         return false;
     }
 
-    QSqlQuery q(db);
-    q.prepare(R"(
+    QSqlQuery& q = lease.prepared(R"(
         INSERT INTO face_embeddings (image_path, face_rect, embedding, global_id, quality, mtime)
         VALUES (?, ?, ?, ?, ?, ?)
     )");
@@ -372,5 +567,1344 @@ bool FaceDatabaseManager::addFacesBatch(const QList<FaceEntry>& entries, const Q
         }
     }
 
+    if (!db.commit()) {
+        qWarning() << "❌ Failed to commit faces:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    ++faceDataVersion;  // cached face summaries read before this are stale
+    return true;
+}
+
+FaceRecord FaceDatabaseManager::faceRecordFromRow(const QSqlQuery& query) {
+    // Expects: id, image_path, face_rect, global_id, quality, embedding
+    FaceRecord record;
+    record.entry.id = query.value(0).toInt();
+    record.entry.imagePath = query.value(1).toString();
+
+    QStringList parts = query.value(2).toString().remove("[").remove("]").split(",");
+    if (parts.size() == 4) {
+        record.entry.faceRect = QRect(parts[0].toInt(), parts[1].toInt(), parts[2].toInt(), parts[3].toInt());
+    }
+
+    record.entry.globalId = query.value(3).toString();
+    record.entry.quality = query.value(4).toFloat();
+    record.embeddingBlob = query.value(5).toByteArray();
+    return record;
+}
+
+bool FaceDatabaseManager::streamFaceQuery(QSqlQuery& query, const FaceChunkCallback& onChunk, int chunkSize) {
+    if (!query.exec()) {
+        qWarning() << "❌ Streaming query failed:" << query.lastError().text();
+        return false;
+    }
+
+    QList<FaceRecord> records;
+    records.reserve(chunkSize);
+
+    while (query.next()) {
+        records.append(faceRecordFromRow(query));
+
+        if (records.size() >= chunkSize) {
+            if (!onChunk(records)) {
+                query.finish();
+                return true;  // caller stopped early
+            }
+            records.clear();
+        }
+    }
+
+    if (!records.isEmpty() && !onChunk(records)) {
+        query.finish();
+        return true;  // caller stopped on the last chunk
+    }
+
+    query.finish();
+    return true;
+}
+
+QList<FaceRecord> FaceDatabaseManager::getFaceRecordsInFolder(const QString& folderPath) {
+    QList<FaceRecord> result;
+    streamFaceEntriesInFolder(folderPath, [&result](const QList<FaceRecord>& chunk) {
+        result.append(chunk);
+        return true;
+    }, 4096);
+    return result;
+}
+
+QList<FaceRecord> FaceDatabaseManager::getFaceRecordsInSubtree(const QString& rootPath) {
+    QList<FaceRecord> result;
+    streamFaceEntriesInSubtree(rootPath, [&result](const QList<FaceRecord>& chunk) {
+        result.append(chunk);
+        return true;
+    }, 4096);
+    return result;
+}
+
+bool FaceDatabaseManager::streamFaceEntriesInFolder(const QString& folderPath, const FaceChunkCallback& onChunk, int chunkSize) {
+    QString modPath = folderPath;
+    modPath.replace("\\", "/");
+
+    // ✅ Cached statements are forward-only, so the driver never buffers every row
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& query = lease.prepared(R"(
+        SELECT id, image_path, face_rect, global_id, quality, embedding
+        FROM face_embeddings
+        WHERE image_path LIKE :folder || '/%' AND image_path NOT LIKE :folder || '/%/%'
+    )");
+    query.bindValue(":folder", modPath);
+
+    return streamFaceQuery(query, onChunk, qMax(1, chunkSize));
+}
+
+bool FaceDatabaseManager::streamFaceEntriesInSubtree(const QString& rootPath, const FaceChunkCallback& onChunk, int chunkSize) {
+    QString modPath = rootPath;
+    modPath.replace("\\", "/");
+
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& query = lease.prepared(R"(
+        SELECT id, image_path, face_rect, global_id, quality, embedding
+        FROM face_embeddings
+        WHERE image_path LIKE :root || '/%'
+    )");
+    query.bindValue(":root", modPath);
+
+    return streamFaceQuery(query, onChunk, qMax(1, chunkSize));
+}
+
+QString FaceDatabaseManager::findImageWithContent(ImageRecord& image) {
+    if (image.contentHash.isEmpty())
+        return QString();
+
+    struct Candidate { QString path; QString fullHash; };
+    QList<Candidate> candidates;
+    {
+        DbLease lease = DbConnectionPool::instance().reader();
+        QSqlQuery& q = lease.prepared("SELECT image_path, full_hash FROM images WHERE content_hash = ? AND image_path <> ?");
+        q.addBindValue(image.contentHash);
+        q.addBindValue(image.imagePath);
+        if (q.exec()) {
+            while (q.next())
+                candidates.append({ q.value(0).toString(), q.value(1).toString() });
+        }
+        q.finish();
+    }
+
+    for (Candidate& c : candidates) {
+        // ✅ Sampled hashes can collide; confirm with the full file hash
+        if (image.fullHash.isEmpty())
+            image.fullHash = fullContentHash(image.imagePath);
+
+        if (c.fullHash.isEmpty()) {
+            c.fullHash = fullContentHash(c.path);
+            if (c.fullHash.isEmpty()) continue;  // source vanished
+
+            DbLease lease = DbConnectionPool::instance().writer();
+            QSqlQuery& u = lease.prepared("UPDATE images SET full_hash = ? WHERE image_path = ?");
+            u.addBindValue(c.fullHash);
+            u.addBindValue(c.path);
+            u.exec();
+        }
+
+        if (!image.fullHash.isEmpty() && c.fullHash == image.fullHash)
+            return c.path;
+    }
+    return QString();
+}
+
+bool FaceDatabaseManager::commitImageWrites(const QList<ImageWrite>& writes, const QList<ScanCheckpoint>& checkpoints) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery& existingFaces = lease.prepared("SELECT id, global_id, quality, clone_of FROM face_embeddings WHERE image_path = ? ORDER BY id");
+    QSqlQuery& clearCrops = lease.prepared("DELETE FROM face_crops WHERE face_id IN (SELECT id FROM face_embeddings WHERE image_path = ?)");
+    QSqlQuery& clearStale = lease.prepared("DELETE FROM face_embeddings WHERE image_path = ?");
+    QSqlQuery& addCrop = lease.prepared("INSERT OR REPLACE INTO face_crops (face_id, pack_offset, byte_size) VALUES (?, ?, ?)");
+    QSqlQuery& shareCrop = lease.prepared(R"(
+        INSERT OR REPLACE INTO face_crops (face_id, pack_offset, byte_size)
+        SELECT ?, pack_offset, byte_size FROM face_crops WHERE face_id = ?
+    )");
+    QSqlQuery& insertFace = lease.prepared(R"(
+        INSERT INTO face_embeddings (image_path, face_rect, embedding, global_id, quality, mtime)
+        VALUES (?, ?, ?, ?, ?, ?)
+    )");
+    QSqlQuery& cloneFaces = lease.prepared(R"(
+        INSERT INTO face_embeddings (image_path, face_rect, embedding, global_id, quality, mtime, clone_of)
+        SELECT ?, face_rect, embedding, global_id, quality, ?, COALESCE(clone_of, id)
+        FROM face_embeddings WHERE image_path = ? ORDER BY id
+    )");
+    QSqlQuery& upsertImage = lease.prepared(R"(
+        INSERT OR REPLACE INTO images (image_path, mtime, file_size, content_hash, full_hash, face_count, file_id)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    )");
+
+    auto rowsOf = [&existingFaces](const QString& path, QList<FaceSummaryDelta>& out) {
+        existingFaces.addBindValue(path);
+        if (!existingFaces.exec()) return false;
+        while (existingFaces.next())
+            out.append({ path, existingFaces.value(1).toString(), existingFaces.value(0).toLongLong(),
+                         existingFaces.value(2).toFloat(), !existingFaces.value(3).isNull() });
+        existingFaces.finish();
+        return true;
+    };
+
+    auto fail = [&](const QString& what) {
+        qWarning() << "❌" << what << db.lastError().text();
+        db.rollback();
+        identities.invalidate();  // centroids may hold faces that were rolled back
+        return false;
+    };
+
+    QList<FaceSummaryDelta> addedFaces, removedFaces;
+    for (const ImageWrite& w : writes) {
+        const ImageRecord& img = w.image;
+        int faceCount = w.entries.size();
+
+        QList<FaceSummaryDelta> replaced;
+        if (!rowsOf(img.imagePath, replaced) || !FolderSummaryIndex::promoteClones(db, replaced, addedFaces))
+            return fail("Failed to read faces of " + img.imagePath);
+        removedFaces += replaced;
+
+        // Each write carries the image's complete face set: it replaces older
+        // versions and makes a replayed write (e.g. after a resumed scan) a no-op
+        clearCrops.addBindValue(img.imagePath);
+        clearStale.addBindValue(img.imagePath);
+        bool ok = clearCrops.exec() && clearStale.exec();
+
+        if (ok && !w.cloneFromPath.isEmpty()) {
+            cloneFaces.addBindValue(img.imagePath);
+            cloneFaces.addBindValue(img.mtime);
+            cloneFaces.addBindValue(w.cloneFromPath);
+            ok = cloneFaces.exec();
+            faceCount = ok ? cloneFaces.numRowsAffected() : 0;
+
+            // Copies were inserted in source id order, so the i-th copy shares the i-th crop
+            QList<FaceSummaryDelta> sources, copies;
+            ok = ok && rowsOf(w.cloneFromPath, sources) && rowsOf(img.imagePath, copies);
+            for (int i = 0; ok && i < copies.size() && i < sources.size(); ++i) {
+                shareCrop.addBindValue(copies[i].faceId);
+                shareCrop.addBindValue(sources[i].faceId);
+                ok = shareCrop.exec();
+            }
+            addedFaces += copies;
+        }
+
+        for (int i = 0; ok && i < w.entries.size(); ++i) {
+            const FaceEntry& entry = w.entries[i];
+            std::vector<float> embedding = w.embeddings.value(i);
+
+            // ✅ Identity assigned here, against the cached centroids, in the same transaction
+            QString globalId = entry.globalId.isEmpty() ? identities.assign(db, embedding) : entry.globalId;
+
+            insertFace.addBindValue(img.imagePath);
+            insertFace.addBindValue(QString("[%1,%2,%3,%4]")
+                                        .arg(entry.faceRect.x()).arg(entry.faceRect.y())
+                                        .arg(entry.faceRect.width()).arg(entry.faceRect.height()));
+            insertFace.addBindValue(embeddingToBlob(embedding));
+            insertFace.addBindValue(globalId);
+            insertFace.addBindValue(entry.quality);
+            insertFace.addBindValue(img.mtime);
+            ok = insertFace.exec();
+            if (!ok) break;
+
+            qint64 faceId = insertFace.lastInsertId().toLongLong();
+            addedFaces.append({ img.imagePath, globalId, faceId, entry.quality });
+
+            // ✅ Keep the scanner's crop; the face list never has to decode the photo
+            const QByteArray crop = w.crops.value(i);
+            qint64 offset = FaceCropStore::instance().append(crop);
+            if (offset >= 0) {
+                addCrop.addBindValue(faceId);
+                addCrop.addBindValue(offset);
+                addCrop.addBindValue(crop.size());
+                ok = addCrop.exec();
+            }
+        }
+
+        if (ok) {
+            upsertImage.addBindValue(img.imagePath);
+            upsertImage.addBindValue(img.mtime);
+            upsertImage.addBindValue(img.fileSize);
+            upsertImage.addBindValue(img.contentHash);
+            upsertImage.addBindValue(img.fullHash.isEmpty() ? QVariant() : QVariant(img.fullHash));
+            upsertImage.addBindValue(faceCount);
+            upsertImage.addBindValue(img.fileId.isEmpty() ? QVariant() : QVariant(img.fileId));
+            ok = upsertImage.exec();
+        }
+
+        if (!ok)
+            return fail("Failed to record image: " + img.imagePath);
+    }
+
+    if (!identities.flush(db) || !FolderSummaryIndex::apply(db, addedFaces, removedFaces))
+        return fail("Failed to update identities or folder summaries");
+
+    // ✅ Every crop of this group commit in one write, before the rows that point at them
+    if (!FaceCropStore::instance().flush())
+        return fail("Failed to write face crops");
+
+    if (!checkpoints.isEmpty()) {
+        QSqlQuery& advance = lease.prepared(R"(
+            UPDATE scan_jobs SET watermark = MAX(watermark, ?), updated_at = ?
+            WHERE job_id = ?
+        )");
+        qint64 now = QDateTime::currentSecsSinceEpoch();
+        for (const ScanCheckpoint& cp : checkpoints) {
+            advance.addBindValue(cp.watermark);
+            advance.addBindValue(now);
+            advance.addBindValue(cp.jobId);
+            if (!advance.exec())
+                return fail(QString("Failed to checkpoint scan job %1").arg(cp.jobId));
+        }
+    }
+
+    if (!db.commit())
+        return fail("Failed to commit image writes");
+    ++faceDataVersion;  // only once readers can see the rows
+    return true;
+}
+
+bool FaceDatabaseManager::movePath(const QString& oldPath, const QString& newPath) {
+    QString from = QDir::cleanPath(oldPath);
+    QString to = QDir::cleanPath(newPath);
+    if (from == to) return true;
+
+    QFileInfo target(to);
+    qint64 newMtime = target.isFile() ? target.lastModified().toSecsSinceEpoch() : 0;
+
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery q(db);
+    bool ok = true;
+
+    // Summary deltas: the moved faces leave their old folders and join the new ones
+    QList<FaceSummaryDelta> removedFaces, addedFaces;
+    if (target.isFile()) {
+        QList<FaceSummaryDelta> moving = FolderSummaryIndex::facesAt(db, from);
+        QList<FaceSummaryDelta> overwritten = FolderSummaryIndex::facesAt(db, to);
+        ok = FolderSummaryIndex::promoteClones(db, overwritten, addedFaces);
+        removedFaces = overwritten + moving;
+        for (FaceSummaryDelta face : moving) {
+            face.imagePath = to;
+            addedFaces.append(face);
+        }
+    } else {
+        removedFaces = FolderSummaryIndex::facesUnder(db, from + "/");
+        for (FaceSummaryDelta face : removedFaces) {
+            face.imagePath = to + face.imagePath.mid(from.length());
+            addedFaces.append(face);
+        }
+    }
+
+    if (target.isFile()) {
+        // Anything indexed at the destination was overwritten by the move, its crops included
+        q.prepare("DELETE FROM face_crops WHERE face_id IN (SELECT id FROM face_embeddings WHERE image_path = ?)");
+        q.addBindValue(to);
+        ok = ok && q.exec();
+
+        for (const char* table : { "face_embeddings", "images" }) {
+            q.prepare(QString("DELETE FROM %1 WHERE image_path = ?").arg(table));
+            q.addBindValue(to);
+            ok = ok && q.exec();
+
+            // A copy+delete move may not keep the timestamp; keep the row valid for the new file
+            q.prepare(QString("UPDATE %1 SET image_path = ?, mtime = ? WHERE image_path = ?").arg(table));
+            q.addBindValue(to);
+            q.addBindValue(newMtime);
+            q.addBindValue(from);
+            ok = ok && q.exec();
+        }
+    } else {
+        // Folder move: rewrite the prefix of every path below it (exact match, no LIKE wildcards)
+        QString fromPrefix = from + "/";
+        for (const char* table : { "face_embeddings", "images" }) {
+            q.prepare(QString(R"(
+                UPDATE %1 SET image_path = ? || substr(image_path, ?)
+                WHERE substr(image_path, 1, ?) = ?
+            )").arg(table));
+            q.addBindValue(to + "/");
+            q.addBindValue(fromPrefix.length() + 1);
+            q.addBindValue(fromPrefix.length());
+            q.addBindValue(fromPrefix);
+            ok = ok && q.exec();
+        }
+    }
+
+    ok = ok && FolderSummaryIndex::apply(db, addedFaces, removedFaces);
+
+    if (!ok) {
+        qWarning() << "❌ Failed to move index rows" << from << "->" << to << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        qWarning() << "❌ Failed to commit move:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    qDebug() << "🚚 Moved index rows" << from << "->" << to;
+    ++faceDataVersion;
+    if (target.isFile())
+        EmbeddingStore::instance().scheduleCatchUp();  // the overwritten destination's vectors
+    return true;
+}
+
+QString FaceDatabaseManager::findMovedImage(const ImageRecord& image) {
+    if (image.fileId.isEmpty())
+        return QString();
+
+    QStringList candidates;
+    {
+        DbLease lease = DbConnectionPool::instance().reader();
+        QSqlQuery& q = lease.prepared(R"(
+            SELECT image_path FROM images
+            WHERE file_id = ? AND file_size = ? AND mtime = ? AND image_path <> ?
+        )");
+        q.addBindValue(image.fileId);
+        q.addBindValue(image.fileSize);
+        q.addBindValue(image.mtime);
+        q.addBindValue(image.imagePath);
+        if (q.exec()) {
+            while (q.next())
+                candidates << q.value(0).toString();
+        }
+        q.finish();
+    }
+
+    // Only a rename if the old path is gone; otherwise it is a hard link or a reused inode
+    for (const QString& path : candidates) {
+        if (!QFileInfo::exists(path))
+            return path;
+    }
+    return QString();
+}
+
+QStringList FaceDatabaseManager::indexedPathsAfter(const QString& afterPath, int limit) {
+    QStringList paths;
+    DbLease lease = DbConnectionPool::instance().reader();
+
+    // Keyset pagination: each batch is an index range scan, no OFFSET
+    QSqlQuery& q = lease.prepared(R"(
+        SELECT image_path FROM images WHERE image_path > ?
+        UNION
+        SELECT image_path FROM face_embeddings WHERE image_path > ?
+        ORDER BY image_path LIMIT ?
+    )");
+    q.addBindValue(afterPath);
+    q.addBindValue(afterPath);
+    q.addBindValue(limit);
+    if (q.exec()) {
+        while (q.next())
+            paths << q.value(0).toString();
+    } else {
+        qWarning() << "❌ Failed to list indexed paths:" << q.lastError().text();
+    }
+    q.finish();
+    return paths;
+}
+
+int FaceDatabaseManager::removePaths(const QStringList& paths) {
+    if (paths.isEmpty()) return 0;
+
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return 0;
+    }
+
+    QSqlQuery& crops = lease.prepared("DELETE FROM face_crops WHERE face_id IN (SELECT id FROM face_embeddings WHERE image_path = ?)");
+    QSqlQuery& faces = lease.prepared("DELETE FROM face_embeddings WHERE image_path = ?");
+    QSqlQuery& images = lease.prepared("DELETE FROM images WHERE image_path = ?");
+
+    int removed = 0;
+    QList<FaceSummaryDelta> removedFaces;
+    QList<FaceSummaryDelta> promoted;
+    for (const QString& path : paths) {
+        QList<FaceSummaryDelta> gone = FolderSummaryIndex::facesAt(db, path);
+        if (!FolderSummaryIndex::promoteClones(db, gone, promoted)) {
+            qWarning() << "❌ Failed to re-point copies of" << path;
+            db.rollback();
+            return 0;
+        }
+        removedFaces += gone;
+        crops.addBindValue(path);
+        faces.addBindValue(path);
+        images.addBindValue(path);
+        if (!crops.exec() || !faces.exec() || !images.exec()) {
+            qWarning() << "❌ Failed to remove index rows for" << path;
+            db.rollback();
+            return 0;
+        }
+        removed += faces.numRowsAffected();
+    }
+
+    if (!FolderSummaryIndex::apply(db, promoted, removedFaces)) {
+        qWarning() << "❌ Failed to update folder summaries:" << db.lastError().text();
+        db.rollback();
+        return 0;
+    }
+
+    if (!db.commit()) {
+        qWarning() << "❌ Failed to commit removal:" << db.lastError().text();
+        db.rollback();
+        return 0;
+    }
+    ++faceDataVersion;
+    EmbeddingStore::instance().scheduleCatchUp();  // flag the deleted vectors
+    return removed;
+}
+
+int FaceDatabaseManager::purgeOrphanIdentities() {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery q(lease.database());
+
+    // Faces still waiting for an identity (older databases) may belong to any centroid: keep them all
+    if (!q.exec(R"(
+            SELECT EXISTS (SELECT 1 FROM face_embeddings
+                           WHERE (global_id IS NULL OR global_id = '') AND length(embedding) > 0)
+        )") || !q.next() || q.value(0).toBool()) {
+        q.finish();
+        return 0;
+    }
+    q.finish();
+
+    // Unnamed centroids go by their rowid (see IdentityIndex); a NULL never matches, so it never protects a row
+    identities.invalidate();
+    if (!q.exec(R"(
+            DELETE FROM global_faces
+            WHERE NOT EXISTS (
+                SELECT 1 FROM face_embeddings f
+                WHERE f.global_id IS NOT NULL
+                  AND f.global_id = COALESCE(global_faces.global_id, CAST(global_faces.rowid AS TEXT))
+            )
+        )")) {
+        qWarning() << "❌ Failed to purge orphan identities:" << q.lastError().text();
+        return 0;
+    }
+    return q.numRowsAffected();
+}
+
+qint64 FaceDatabaseManager::reclaimableBytes() {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery q(lease.database());
+
+    qint64 freePages = 0, pageSize = 0;
+    if (q.exec("PRAGMA freelist_count") && q.next())
+        freePages = q.value(0).toLongLong();
+    if (q.exec("PRAGMA page_size") && q.next())
+        pageSize = q.value(0).toLongLong();
+    return freePages * pageSize;
+}
+
+bool FaceDatabaseManager::compact() {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery q(lease.database());
+
+    int autoVacuum = 0;
+    if (q.exec("PRAGMA auto_vacuum") && q.next())
+        autoVacuum = q.value(0).toInt();
+    q.finish();
+
+    // ✅ Incremental mode frees pages cheaply; switching to it takes one full VACUUM
+    bool ok;
+    if (autoVacuum == 2) {
+        ok = q.exec("PRAGMA incremental_vacuum");
+        while (ok && q.next()) {}
+    } else {
+        q.exec("PRAGMA auto_vacuum = INCREMENTAL");
+        ok = q.exec("VACUUM");
+    }
+
+    if (!ok)
+        qWarning() << "❌ Compaction failed:" << q.lastError().text();
+    return ok;
+}
+
+bool FaceDatabaseManager::addLibraryRoot(const QString& rootPath, bool recursive) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery& q = lease.prepared(R"(
+        INSERT INTO library_roots (root_path, recursive) VALUES (?, ?)
+        ON CONFLICT (root_path) DO UPDATE SET recursive = MAX(recursive, excluded.recursive)
+    )");
+    q.addBindValue(QDir::cleanPath(rootPath));
+    q.addBindValue(recursive ? 1 : 0);
+    if (!q.exec()) {
+        qWarning() << "❌ Failed to register library root:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QHash<QString, bool> FaceDatabaseManager::libraryRoots() {
+    QHash<QString, bool> roots;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT root_path, recursive FROM library_roots");
+    if (q.exec()) {
+        while (q.next())
+            roots.insert(q.value(0).toString(), q.value(1).toInt() != 0);
+    }
+    q.finish();
+    return roots;
+}
+
+QByteArray FaceDatabaseManager::directoryListing(const QString& dirPath, qint64 dirMtime) {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT listing FROM directory_listings WHERE dir_path = ? AND dir_mtime = ?");
+    q.addBindValue(dirPath);
+    q.addBindValue(dirMtime);
+    QByteArray listing;
+    if (q.exec() && q.next())
+        listing = q.value(0).toByteArray();
+    q.finish();
+    return listing;
+}
+
+bool FaceDatabaseManager::saveDirectoryListing(const QString& dirPath, qint64 dirMtime, const QByteArray& listing) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery& q = lease.prepared(R"(
+        INSERT INTO directory_listings (dir_path, dir_mtime, listing) VALUES (?, ?, ?)
+        ON CONFLICT(dir_path) DO UPDATE SET dir_mtime = excluded.dir_mtime, listing = excluded.listing
+    )");
+    q.addBindValue(dirPath);
+    q.addBindValue(dirMtime);
+    q.addBindValue(listing);
+    if (!q.exec()) {
+        qWarning() << "❌ Failed to save folder listing:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool FaceDatabaseManager::dropDirectoryListing(const QString& dirPath) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery& q = lease.prepared("DELETE FROM directory_listings WHERE dir_path = ?");
+    q.addBindValue(dirPath);
+    return q.exec();
+}
+
+bool FaceDatabaseManager::mergeShard(const QString& shardPath, ShardMergeReport& report) {
+    QElapsedTimer timer;
+    timer.start();
+    report = ShardMergeReport();
+
+    if (QFileInfo(shardPath).absoluteFilePath() == QFileInfo(dbFilePath).absoluteFilePath()) {
+        qWarning() << "❌ Refusing to merge the database into itself:" << shardPath;
+        return false;
+    }
+
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    QSqlQuery q(db);
+
+    q.prepare("ATTACH DATABASE ? AS shard");
+    q.addBindValue(QFileInfo(shardPath).absoluteFilePath());
+    if (!q.exec()) {
+        qWarning() << "❌ Cannot attach shard:" << shardPath << q.lastError().text();
+        return false;
+    }
+
+    auto detach = [&]() {
+        QSqlQuery d(db);
+        d.exec("DETACH DATABASE shard");
+    };
+
+    q.exec(R"(
+        SELECT COUNT(*) FROM shard.sqlite_master
+        WHERE type = 'table' AND name IN ('face_embeddings', 'images', 'global_faces')
+    )");
+    if (!q.next() || q.value(0).toInt() != 3) {
+        qWarning() << "❌ Not a face database shard:" << shardPath;
+        q.finish();
+        detach();
+        return false;
+    }
+    q.finish();
+
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        detach();
+        return false;
+    }
+    identities.invalidate();  // global_faces is edited directly below
+
+    // --- Identity reconciliation: greedy nearest-centroid clustering ---
+    // The shard already kept its own identities apart, so each main centroid
+    // takes at most one of them: once matched or added by this shard it is
+    // out of the running for the shard's other identities.
+    struct Centroid {
+        qint64 rowId = 0;
+        QString id;
+        std::vector<float> embedding;
+        qint64 count = 1;
+        bool dirty = false;
+        bool fromShard = false;
+    };
+
+    QList<Centroid> centroids;
+    bool ok = q.exec(R"(
+        SELECT rowid, COALESCE(global_id, CAST(rowid AS TEXT)), avg_embedding, COALESCE(count, 1)
+        FROM main.global_faces
+    )");
+    while (ok && q.next()) {
+        Centroid c;
+        c.rowId = q.value(0).toLongLong();
+        c.id = q.value(1).toString();
+        c.embedding = blobToEmbedding(q.value(2).toByteArray());
+        c.count = qMax<qint64>(1, q.value(3).toLongLong());
+        centroids.append(c);
+    }
+
+    ok = ok && q.exec("CREATE TEMP TABLE IF NOT EXISTS shard_id_map (shard_id TEXT PRIMARY KEY, main_id TEXT)");
+    ok = ok && q.exec("DELETE FROM temp.shard_id_map");
+
+    QSqlQuery shardIds(db);
+    shardIds.setForwardOnly(true);
+    ok = ok && shardIds.exec(R"(
+        SELECT COALESCE(global_id, CAST(rowid AS TEXT)), label, avg_embedding, COALESCE(count, 1)
+        FROM shard.global_faces
+    )");
+
+    QSqlQuery mapId(db);
+    mapId.prepare("INSERT OR REPLACE INTO temp.shard_id_map (shard_id, main_id) VALUES (?, ?)");
+    QSqlQuery addIdentity(db);
+    addIdentity.prepare("INSERT INTO main.global_faces (label, avg_embedding, count) VALUES (?, ?, ?)");
+    QSqlQuery nameIdentity(db);
+    nameIdentity.prepare("UPDATE main.global_faces SET global_id = ? WHERE rowid = ?");
+
+    while (ok && shardIds.next()) {
+        QString shardId = shardIds.value(0).toString();
+        std::vector<float> embedding = blobToEmbedding(shardIds.value(2).toByteArray());
+        qint64 count = qMax<qint64>(1, shardIds.value(3).toLongLong());
+
+        int best = -1;
+        float bestDist = 0.5f;
+        for (int i = 0; i < centroids.size(); ++i) {
+            if (centroids[i].fromShard || centroids[i].embedding.size() != embedding.size()) continue;
+            float dist = l2Distance(embedding, centroids[i].embedding);
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = i;
+            }
+        }
+
+        QString mainId;
+        if (best >= 0) {
+            // Count-weighted centroid of both sides
+            Centroid& c = centroids[best];
+            for (size_t k = 0; k < embedding.size(); ++k)
+                c.embedding[k] = (c.embedding[k] * c.count + embedding[k] * count) / (c.count + count);
+            c.count += count;
+            c.dirty = true;
+            c.fromShard = true;
+            mainId = c.id;
+            ++report.identitiesMatched;
+        } else {
+            addIdentity.addBindValue(shardIds.value(1));
+            addIdentity.addBindValue(embeddingToBlob(embedding));
+            addIdentity.addBindValue(count);
+            ok = addIdentity.exec();
+            if (!ok) break;
+
+            Centroid c;
+            c.rowId = addIdentity.lastInsertId().toLongLong();
+            c.id = QString::number(c.rowId);
+            c.embedding = embedding;
+            c.count = count;
+            c.fromShard = true;
+            centroids.append(c);
+            mainId = c.id;
+
+            nameIdentity.addBindValue(mainId);
+            nameIdentity.addBindValue(c.rowId);
+            ok = nameIdentity.exec();
+            ++report.identitiesAdded;
+        }
+
+        if (ok) {
+            mapId.addBindValue(shardId);
+            mapId.addBindValue(mainId);
+            ok = mapId.exec();
+        }
+    }
+    shardIds.finish();
+
+    QSqlQuery updateCentroid(db);
+    updateCentroid.prepare("UPDATE main.global_faces SET global_id = ?, avg_embedding = ?, count = ? WHERE rowid = ?");
+    for (int i = 0; ok && i < centroids.size(); ++i) {
+        const Centroid& c = centroids[i];
+        if (!c.dirty) continue;
+        updateCentroid.addBindValue(c.id);
+        updateCentroid.addBindValue(embeddingToBlob(c.embedding));
+        updateCentroid.addBindValue(c.count);
+        updateCentroid.addBindValue(c.rowId);
+        ok = updateCentroid.exec();
+    }
+
+    // --- Rows: every path the shard indexed replaces what main had for it ---
+    // (shard crops stay in the shard's pack; FaceCropStore regenerates them on demand)
+    ok = ok && q.exec(R"(
+        DELETE FROM main.face_crops WHERE face_id IN (
+            SELECT id FROM main.face_embeddings WHERE image_path IN (
+                SELECT image_path FROM shard.images
+                UNION SELECT image_path FROM shard.face_embeddings
+            )
+        )
+    )");
+    ok = ok && q.exec(R"(
+        DELETE FROM main.face_embeddings WHERE image_path IN (
+            SELECT image_path FROM shard.images
+            UNION SELECT image_path FROM shard.face_embeddings
+        )
+    )");
+    ok = ok && q.exec(R"(
+        INSERT INTO main.face_embeddings (image_path, face_rect, embedding, global_id, quality, mtime)
+        SELECT f.image_path, f.face_rect, f.embedding, COALESCE(m.main_id, f.global_id), f.quality, f.mtime
+        FROM shard.face_embeddings f
+        LEFT JOIN temp.shard_id_map m ON m.shard_id = f.global_id
+        ORDER BY f.id
+    )");
+    if (ok) report.faces = q.numRowsAffected();
+
+    // Copies whose canonical row was just replaced: the oldest copy takes over, the rest point at it
+    ok = ok && q.exec(R"(
+        CREATE TEMP TABLE IF NOT EXISTS clone_heirs (old_id INTEGER PRIMARY KEY, heir INTEGER)
+    )");
+    ok = ok && q.exec("DELETE FROM temp.clone_heirs");
+    ok = ok && q.exec(R"(
+        INSERT INTO temp.clone_heirs (old_id, heir)
+        SELECT clone_of, MIN(id) FROM main.face_embeddings
+        WHERE clone_of IS NOT NULL AND clone_of NOT IN (SELECT id FROM main.face_embeddings)
+        GROUP BY clone_of
+    )");
+    ok = ok && q.exec(R"(
+        UPDATE main.face_embeddings
+        SET clone_of = NULLIF((SELECT heir FROM temp.clone_heirs WHERE old_id = clone_of), id)
+        WHERE clone_of IN (SELECT old_id FROM temp.clone_heirs)
+    )");
+
+    // Shard copies point at the main rows of their shard canonical face (same file, same rectangle)
+    bool shardHasClones = false;
+    if (ok && q.exec("PRAGMA shard.table_info(face_embeddings)")) {
+        while (q.next())
+            shardHasClones = shardHasClones || q.value(1).toString() == "clone_of";
+        q.finish();
+    }
+    if (shardHasClones) {
+        ok = ok && q.exec(R"(
+            UPDATE main.face_embeddings SET clone_of = (
+                SELECT m.id FROM shard.face_embeddings c
+                JOIN shard.face_embeddings s ON s.id = c.clone_of
+                JOIN main.face_embeddings m ON m.image_path = s.image_path AND m.face_rect = s.face_rect
+                WHERE c.image_path = main.face_embeddings.image_path AND c.face_rect = main.face_embeddings.face_rect
+                LIMIT 1
+            )
+            WHERE image_path IN (SELECT image_path FROM shard.face_embeddings WHERE clone_of IS NOT NULL)
+        )");
+    }
+
+    ok = ok && q.exec(R"(
+        INSERT OR REPLACE INTO main.images (image_path, mtime, file_size, content_hash, full_hash, face_count, file_id)
+        SELECT image_path, mtime, file_size, content_hash, full_hash, face_count, file_id FROM shard.images
+    )");
+    if (ok) report.images = q.numRowsAffected();
+
+    ok = ok && q.exec("INSERT OR IGNORE INTO main.library_roots (root_path) SELECT root_path FROM shard.library_roots");
+    ok = ok && q.exec("DELETE FROM temp.shard_id_map");
+
+    if (!ok || !db.commit()) {
+        qWarning() << "❌ Shard merge failed:" << shardPath << q.lastError().text() << db.lastError().text();
+        db.rollback();
+        detach();
+        return false;
+    }
+    ++faceDataVersion;
+    detach();
+
+    EmbeddingStore::instance().catchUp();
+    rebuildFolderSummaries();
+
+    qDebug() << "🧩 Merged shard" << shardPath << ":" << report.images << "image(s)," << report.faces << "face(s),"
+             << report.identitiesMatched << "identities matched," << report.identitiesAdded << "added in"
+             << timer.elapsed() << "ms";
+    return true;
+}
+
+QList<QPair<qint64, QByteArray>> FaceDatabaseManager::embeddingsAfter(qint64 afterId, int limit) {
+    QList<QPair<qint64, QByteArray>> rows;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT id, embedding FROM face_embeddings WHERE id > ? AND clone_of IS NULL ORDER BY id LIMIT ?");
+    q.addBindValue(afterId);
+    q.addBindValue(limit);
+    if (q.exec()) {
+        while (q.next())
+            rows.append({ q.value(0).toLongLong(), q.value(1).toByteArray() });
+    }
+    q.finish();
+    return rows;
+}
+
+QList<QPair<qint64, qint64>> FaceDatabaseManager::tombstonesAfter(qint64 afterSeq, int limit) {
+    QList<QPair<qint64, qint64>> rows;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT seq, face_id FROM face_tombstones WHERE seq > ? ORDER BY seq LIMIT ?");
+    q.addBindValue(afterSeq);
+    q.addBindValue(limit);
+    if (q.exec()) {
+        while (q.next())
+            rows.append({ q.value(0).toLongLong(), q.value(1).toLongLong() });
+    }
+    q.finish();
+    return rows;
+}
+
+qint64 FaceDatabaseManager::latestTombstone() {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT COALESCE(MAX(seq), 0) FROM face_tombstones");
+    qint64 seq = (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+    q.finish();
+    return seq;
+}
+
+bool FaceDatabaseManager::trimTombstones(qint64 upToSeq) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlQuery& q = lease.prepared("DELETE FROM face_tombstones WHERE seq <= ?");
+    q.addBindValue(upToSeq);
+    const bool ok = q.exec();
+    if (!ok)
+        qWarning() << "⚠️ Failed to trim face tombstones:" << q.lastError().text();
+    q.finish();
+    return ok;
+}
+
+QList<FaceRef> FaceDatabaseManager::faceRefs(const QString& folderPath, bool recursive) {
+    QString modPath = folderPath;
+    modPath.replace("\\", "/");
+
+    QList<FaceRef> faces;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared(recursive ? QString(R"(
+            SELECT id, COALESCE(clone_of, id), image_path, global_id
+            FROM face_embeddings
+            WHERE image_path LIKE :folder || '/%'
+        )") : QString(R"(
+            SELECT id, COALESCE(clone_of, id), image_path, global_id
+            FROM face_embeddings
+            WHERE image_path LIKE :folder || '/%' AND image_path NOT LIKE :folder || '/%/%'
+        )"));
+    q.bindValue(":folder", modPath);
+
+    if (q.exec()) {
+        while (q.next()) {
+            FaceRef face;
+            face.id = q.value(0).toLongLong();
+            face.embeddingId = q.value(1).toLongLong();
+            face.imagePath = q.value(2).toString();
+            face.globalId = q.value(3).toString();
+            faces.append(face);
+        }
+    } else {
+        qWarning() << "❌ Face query failed:" << q.lastError().text();
+    }
+    q.finish();
+    return faces;
+}
+
+QHash<qint64, QByteArray> FaceDatabaseManager::embeddingsByIds(const QList<qint64>& ids) {
+    QHash<qint64, QByteArray> blobs;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery q(lease.database());
+
+    // Bounded IN lists: one query per few hundred misses, not one per face
+    constexpr int CHUNK = 500;
+    for (int start = 0; start < ids.size(); start += CHUNK) {
+        const QList<qint64> chunk = ids.mid(start, CHUNK);
+        QStringList marks;
+        for (int i = 0; i < chunk.size(); ++i) marks << "?";
+        q.prepare(QString("SELECT id, embedding FROM face_embeddings WHERE id IN (%1)").arg(marks.join(',')));
+        for (qint64 id : chunk)
+            q.addBindValue(id);
+        if (!q.exec()) {
+            qWarning() << "❌ Embedding lookup failed:" << q.lastError().text();
+            break;
+        }
+        while (q.next())
+            blobs.insert(q.value(0).toLongLong(), q.value(1).toByteArray());
+    }
+    return blobs;
+}
+
+qint64 FaceDatabaseManager::faceRowCount() {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT COUNT(*) FROM face_embeddings WHERE clone_of IS NULL");
+    qint64 count = (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+    q.finish();
+    return count;
+}
+
+QList<FolderPerson> FaceDatabaseManager::folderPersonSummary(const QString& folderPath, bool recursive) {
+    QList<FolderPerson> people;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared(recursive ? QString(R"(
+            SELECT s.global_id, s.subtree_count, s.subtree_best_id, s.subtree_best_quality, f.image_path, f.face_rect,
+                   f.embedding
+            FROM folder_person_summary s LEFT JOIN face_embeddings f ON f.id = s.subtree_best_id
+            WHERE s.folder_path = ? AND s.subtree_count > 0
+            ORDER BY s.subtree_count DESC
+        )") : QString(R"(
+            SELECT s.global_id, s.direct_count, s.direct_best_id, s.direct_best_quality, f.image_path, f.face_rect,
+                   f.embedding
+            FROM folder_person_summary s LEFT JOIN face_embeddings f ON f.id = s.direct_best_id
+            WHERE s.folder_path = ? AND s.direct_count > 0
+            ORDER BY s.direct_count DESC
+        )"));
+    q.addBindValue(FolderSummaryIndex::folderKey(folderPath));
+
+    if (q.exec()) {
+        while (q.next()) {
+            FolderPerson p;
+            p.globalId = q.value(0).toString();
+            p.count = q.value(1).toInt();
+            p.bestFaceId = q.value(2).toLongLong();
+            p.bestQuality = q.value(3).toFloat();
+            p.bestImagePath = q.value(4).toString();
+
+            QStringList parts = q.value(5).toString().remove("[").remove("]").split(",");
+            if (parts.size() == 4)
+                p.bestFaceRect = QRect(parts[0].toInt(), parts[1].toInt(), parts[2].toInt(), parts[3].toInt());
+            p.embedding = blobToEmbedding(q.value(6).toByteArray());
+            people.append(p);
+        }
+    } else {
+        qWarning() << "❌ Folder summary query failed:" << q.lastError().text();
+    }
+    q.finish();
+    return people;
+}
+
+bool FaceDatabaseManager::rebuildFolderSummaries() {
+    QElapsedTimer timer;
+    timer.start();
+
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+    identities.invalidate();
+
+    // ✅ Legacy rows first: give every face with an embedding an identity
+    QSqlQuery pending(db);
+    pending.prepare(R"(
+        SELECT id, embedding FROM face_embeddings
+        WHERE (global_id IS NULL OR global_id = '') AND length(embedding) > 0 AND id > ?
+        ORDER BY id LIMIT 2048
+    )");
+    QSqlQuery setId(db);
+    setId.prepare("UPDATE face_embeddings SET global_id = ? WHERE id = ?");
+
+    bool ok = true;
+    qint64 lastId = 0;
+    int assigned = 0;
+    while (ok) {
+        pending.addBindValue(lastId);
+        if (!pending.exec()) { ok = false; break; }
+
+        QList<QPair<qint64, QByteArray>> rows;
+        while (pending.next())
+            rows.append({ pending.value(0).toLongLong(), pending.value(1).toByteArray() });
+        pending.finish();
+        if (rows.isEmpty()) break;
+
+        for (const auto& row : rows) {
+            QString globalId = identities.assign(db, blobToEmbedding(row.second));
+            if (globalId.isEmpty()) continue;
+            setId.addBindValue(globalId);
+            setId.addBindValue(row.first);
+            if (!(ok = setId.exec())) break;
+            ++assigned;
+        }
+        lastId = rows.last().first;
+    }
+
+    ok = ok && identities.flush(db) && FolderSummaryIndex::rebuild(db);
+    if (!ok || !db.commit()) {
+        qWarning() << "❌ Failed to rebuild folder summaries:" << db.lastError().text();
+        db.rollback();
+        identities.invalidate();
+        return false;
+    }
+    ++faceDataVersion;
+
+    qDebug() << "📊 Folder summaries rebuilt, identities assigned to" << assigned << "legacy face(s) in"
+             << timer.elapsed() << "ms";
+    return true;
+}
+
+bool FaceDatabaseManager::ensureFolderSummaries() {
+    bool needed = false;
+    {
+        DbLease lease = DbConnectionPool::instance().reader();
+        QSqlQuery& q = lease.prepared(R"(
+            SELECT EXISTS (SELECT 1 FROM face_embeddings
+                           WHERE (global_id IS NULL OR global_id = '') AND length(embedding) > 0)
+                OR (EXISTS (SELECT 1 FROM face_embeddings) AND NOT EXISTS (SELECT 1 FROM folder_person_summary))
+        )");
+        needed = q.exec() && q.next() && q.value(0).toBool();
+        q.finish();
+    }
+    return needed ? rebuildFolderSummaries() : true;
+}
+
+QHash<qint64, QPair<qint64, int>> FaceDatabaseManager::faceCropLocations(const QList<qint64>& faceIds) {
+    QHash<qint64, QPair<qint64, int>> locations;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery q(lease.database());
+    q.setForwardOnly(true);
+
+    // Chunked IN lists stay well below SQLite's bound-parameter limit
+    const int chunk = 500;
+    for (int start = 0; start < faceIds.size(); start += chunk) {
+        int n = qMin(chunk, static_cast<int>(faceIds.size()) - start);
+        QStringList marks;
+        for (int i = 0; i < n; ++i)
+            marks << "?";
+
+        q.prepare(QString("SELECT face_id, pack_offset, byte_size FROM face_crops WHERE face_id IN (%1)")
+                      .arg(marks.join(',')));
+        for (int i = 0; i < n; ++i)
+            q.addBindValue(faceIds[start + i]);
+        if (!q.exec()) {
+            qWarning() << "❌ Face crop lookup failed:" << q.lastError().text();
+            break;
+        }
+        while (q.next())
+            locations.insert(q.value(0).toLongLong(), { q.value(1).toLongLong(), q.value(2).toInt() });
+    }
+    return locations;
+}
+
+bool FaceDatabaseManager::addFaceCropLocations(const QList<QPair<qint64, QPair<qint64, int>>>& locations) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Only for faces that still exist; the row may have been rescanned meanwhile
+    QSqlQuery& q = lease.prepared(R"(
+        INSERT OR REPLACE INTO face_crops (face_id, pack_offset, byte_size)
+        SELECT id, ?, ? FROM face_embeddings WHERE id = ?
+    )");
+    for (const auto& location : locations) {
+        q.addBindValue(location.second.first);
+        q.addBindValue(location.second.second);
+        q.addBindValue(location.first);
+        if (!q.exec()) {
+            qWarning() << "❌ Failed to record face crop:" << q.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
     return db.commit();
 }
+
+qint64 FaceDatabaseManager::createScanJob(const QStringList& roots, const QString& options) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return 0;
+    }
+
+    QStringList cleanRoots;
+    for (const QString& root : roots)
+        cleanRoots << QDir::cleanPath(root);
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QSqlQuery q(db);
+    q.prepare(R"(
+        INSERT INTO scan_jobs (roots, options, state, file_count, watermark, created_at, updated_at)
+        VALUES (?, ?, 'enumerating', 0, 0, ?, ?)
+    )");
+    q.addBindValue(cleanRoots.join('\n'));
+    q.addBindValue(options);
+    q.addBindValue(now);
+    q.addBindValue(now);
+    bool ok = q.exec();
+    qint64 jobId = ok ? q.lastInsertId().toLongLong() : 0;
+
+    // The roots seed the directory frontier
+    q.prepare("INSERT OR IGNORE INTO scan_job_dirs (job_id, dir_path, done) VALUES (?, ?, 0)");
+    for (int i = 0; ok && i < cleanRoots.size(); ++i) {
+        q.addBindValue(jobId);
+        q.addBindValue(cleanRoots[i]);
+        ok = q.exec();
+    }
+
+    if (!ok || !db.commit()) {
+        qWarning() << "❌ Failed to create scan job:" << q.lastError().text();
+        db.rollback();
+        return 0;
+    }
+    return jobId;
+}
+
+bool FaceDatabaseManager::loadScanJob(qint64 jobId, ScanJobRecord& job) {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared(R"(
+        SELECT roots, options, state, file_count, watermark FROM scan_jobs WHERE job_id = ?
+    )");
+    q.addBindValue(jobId);
+    bool found = q.exec() && q.next();
+    if (found) {
+        job.jobId = jobId;
+        job.roots = q.value(0).toString().split('\n', Qt::SkipEmptyParts);
+        job.options = q.value(1).toString();
+        job.state = q.value(2).toString();
+        job.fileCount = q.value(3).toLongLong();
+        job.watermark = q.value(4).toLongLong();
+    }
+    q.finish();
+    return found;
+}
+
+qint64 FaceDatabaseManager::latestUnfinishedScanJob() {
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT MAX(job_id) FROM scan_jobs WHERE state <> 'done'");
+    qint64 jobId = (q.exec() && q.next()) ? q.value(0).toLongLong() : 0;
+    q.finish();
+    return jobId;
+}
+
+QStringList FaceDatabaseManager::pendingScanJobDirs(qint64 jobId, int limit) {
+    QStringList dirs;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared("SELECT dir_path FROM scan_job_dirs WHERE job_id = ? AND done = 0 LIMIT ?");
+    q.addBindValue(jobId);
+    q.addBindValue(limit);
+    if (q.exec()) {
+        while (q.next())
+            dirs << q.value(0).toString();
+    }
+    q.finish();
+    return dirs;
+}
+
+bool FaceDatabaseManager::recordScanJobDir(qint64 jobId, const QString& dirPath,
+                                           const QStringList& files, const QStringList& subdirs) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // ✅ Files, new frontier entries and the "done" mark land together, so a
+    // crash never loses or double-numbers a directory's files
+    QSqlQuery& count = lease.prepared("SELECT file_count FROM scan_jobs WHERE job_id = ?");
+    count.addBindValue(jobId);
+    bool ok = count.exec() && count.next();
+    qint64 seq = ok ? count.value(0).toLongLong() : 0;
+    count.finish();
+
+    QSqlQuery& addFile = lease.prepared("INSERT INTO scan_job_files (job_id, seq, path) VALUES (?, ?, ?)");
+    for (int i = 0; ok && i < files.size(); ++i) {
+        addFile.addBindValue(jobId);
+        addFile.addBindValue(seq++);
+        addFile.addBindValue(files[i]);
+        ok = addFile.exec();
+    }
+
+    QSqlQuery& addDir = lease.prepared("INSERT OR IGNORE INTO scan_job_dirs (job_id, dir_path, done) VALUES (?, ?, 0)");
+    for (int i = 0; ok && i < subdirs.size(); ++i) {
+        addDir.addBindValue(jobId);
+        addDir.addBindValue(subdirs[i]);
+        ok = addDir.exec();
+    }
+
+    QSqlQuery& markDone = lease.prepared("UPDATE scan_job_dirs SET done = 1 WHERE job_id = ? AND dir_path = ?");
+    if (ok) {
+        markDone.addBindValue(jobId);
+        markDone.addBindValue(dirPath);
+        ok = markDone.exec();
+    }
+
+    QSqlQuery& setCount = lease.prepared("UPDATE scan_jobs SET file_count = ?, updated_at = ? WHERE job_id = ?");
+    if (ok) {
+        setCount.addBindValue(seq);
+        setCount.addBindValue(QDateTime::currentSecsSinceEpoch());
+        setCount.addBindValue(jobId);
+        ok = setCount.exec();
+    }
+
+    if (!ok || !db.commit()) {
+        qWarning() << "❌ Failed to record scan directory:" << dirPath << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+QStringList FaceDatabaseManager::scanJobFiles(qint64 jobId, qint64 fromSeq, int limit) {
+    QStringList paths;
+    DbLease lease = DbConnectionPool::instance().reader();
+    QSqlQuery& q = lease.prepared(R"(
+        SELECT path FROM scan_job_files
+        WHERE job_id = ? AND seq >= ?
+        ORDER BY seq LIMIT ?
+    )");
+    q.addBindValue(jobId);
+    q.addBindValue(fromSeq);
+    q.addBindValue(limit);
+    if (q.exec()) {
+        while (q.next())
+            paths << q.value(0).toString();
+    }
+    q.finish();
+    return paths;
+}
+
+bool FaceDatabaseManager::setScanJobState(qint64 jobId, const QString& state) {
+    DbLease lease = DbConnectionPool::instance().writer();
+    QSqlDatabase db = lease.database();
+    if (!db.transaction()) {
+        qWarning() << "⚠️ Failed to start transaction:" << db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery q(db);
+    q.prepare("UPDATE scan_jobs SET state = ?, updated_at = ? WHERE job_id = ?");
+    q.addBindValue(state);
+    q.addBindValue(QDateTime::currentSecsSinceEpoch());
+    q.addBindValue(jobId);
+    bool ok = q.exec();
+
+    // A finished job no longer needs its (potentially huge) file list
+    if (ok && state == "done") {
+        for (const char* table : { "scan_job_files", "scan_job_dirs" }) {
+            q.prepare(QString("DELETE FROM %1 WHERE job_id = ?").arg(table));
+            q.addBindValue(jobId);
+            ok = ok && q.exec();
+        }
+    }
+
+    if (!ok || !db.commit()) {
+        qWarning() << "❌ Failed to update scan job" << jobId << q.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
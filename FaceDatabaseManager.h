@@ -6,19 +6,89 @@
 #include <QRect>
 #include <QString>
 #include <QList>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
 #include <vector>
+#include <atomic>
 #include"FaceTypes.h"
+#include "DbConnectionPool.h"
+#include "IdentityIndex.h"
+
+// Per-connection SQLite tuning applied whenever a connection is opened
+struct SqliteProfile {
+    bool tuned = true;                            // false = SQLite defaults (for before/after timing)
+    int cacheSizeKiB = 64 * 1024;                 // PRAGMA cache_size (negative = KiB)
+    qint64 mmapSizeBytes = 256LL * 1024 * 1024;   // PRAGMA mmap_size
+    int busyTimeoutMs = 5000;                     // PRAGMA busy_timeout
+    int maxReaderConnections = 0;                 // concurrent reader leases, 0 = ideal thread count
+};
+
+// One image's worth of index updates; many of these share a single transaction
+struct ImageWrite {
+    ImageRecord image;
+    QList<FaceEntry> entries;
+    QList<std::vector<float>> embeddings;
+    QString cloneFromPath;      // non-empty: copy the face rows of this identical file
+    QList<QByteArray> crops;    // encoded face crops (FaceCropStore), parallel to entries
+};
+
+// Durable record of a long scan (see ScanJob); file seqs run 0..fileCount-1
+struct ScanJobRecord {
+    qint64 jobId = 0;
+    QStringList roots;
+    QString options;
+    QString state;              // "enumerating", "running" or "done"
+    qint64 fileCount = 0;       // files enumerated so far
+    qint64 watermark = 0;       // every file with seq < watermark is committed
+};
+
+// Advances a job's watermark inside the same transaction as the faces it covers
+struct ScanCheckpoint {
+    qint64 jobId = 0;
+    qint64 watermark = 0;
+};
+
+// One identity in a folder's face list (from folder_person_summary)
+struct FolderPerson {
+    QString globalId;
+    int count = 0;              // faces directly in the folder, or anywhere below it
+    qint64 bestFaceId = 0;      // highest quality face within the same scope
+    float bestQuality = 0.0f;
+    QString bestImagePath;
+    QRect bestFaceRect;
+    std::vector<float> embedding;   // the best face's vector, read in the same query
+};
+
+// Outcome of folding one shard database into this one
+struct ShardMergeReport {
+    int images = 0;
+    int faces = 0;
+    int identitiesMatched = 0;      // shard identities mapped onto an existing global_id
+    int identitiesAdded = 0;
+};
 
 class FaceDatabaseManager {
 public:
     static FaceDatabaseManager& instance();
+
+    // Overrides <appDir>/.cache/face_database.sqlite; call before the first instance()
+    static void setDatabasePath(const QString& dbPath);
+    // Profile the first connection opens with; call before the first instance()
+    static void setInitialConnectionProfile(const SqliteProfile& profile);
     bool open(const QString& dbPath);
+    QString databaseFilePath() const { return dbFilePath; }
     void ensureTables();
 
+    // Reopens pooled connections lazily with the new profile
+    void setConnectionProfile(const SqliteProfile& profile);
+    SqliteProfile connectionProfile() const;
+    DbPoolMetrics connectionMetrics() const;
+
     bool addFace(const QString& imagePath, const QRect& rect, const std::vector<float>& embedding, float quality, qint64 mtime);
     QList<FaceEntry> getFacesForFolder(const QString& folderPath);
     QList<FaceEntry> getFacesByGlobalId(const QString& globalId);
-    std::vector<float> getEmbeddingById(int id);
+    std::vector<float> getEmbeddingById(qint64 id);
     bool faceAlreadyProcessed(const QString& imagePath, qint64 mtime);
 
     QString assignOrFindGlobalID(const std::vector<float>& embedding);
@@ -26,13 +96,108 @@ public:
     QList<FaceEntry> getFaceEntriesInSubtree(const QString& rootPath);
     bool addFacesBatch(const QList<FaceEntry>& entries, const QList<std::vector<float>>& embeddings);
 
+    // Records images (and their faces or cloned faces) in one transaction.
+    // Rewriting an image replaces its rows, so replaying a write is harmless.
+    bool commitImageWrites(const QList<ImageWrite>& writes, const QList<ScanCheckpoint>& checkpoints = {});
+
+    // Path of an already indexed file with identical content, or empty.
+    // Confirms quick-hash matches with a full hash (stored in image.fullHash).
+    QString findImageWithContent(ImageRecord& image);
+
+    // Rewrites image_path for a moved file or folder (and everything below it) in one transaction
+    bool movePath(const QString& oldPath, const QString& newPath);
+
+    // Folders the user indexed; watched for changes. A root once registered as
+    // recursive stays recursive; libraryRoots() maps each root to that flag.
+    bool addLibraryRoot(const QString& rootPath, bool recursive = true);
+    QHash<QString, bool> libraryRoots();
+
+    // directory_listings: serialized folder listings (DirectoryCache), valid while the folder's mtime matches
+    QByteArray directoryListing(const QString& dirPath, qint64 dirMtime);
+    bool saveDirectoryListing(const QString& dirPath, qint64 dirMtime, const QByteArray& listing);
+    bool dropDirectoryListing(const QString& dirPath);
+
+    // Scan jobs: enumeration and progress survive crashes (see ScanJob)
+    qint64 createScanJob(const QStringList& roots, const QString& options);
+    bool loadScanJob(qint64 jobId, ScanJobRecord& job);
+    qint64 latestUnfinishedScanJob();
+    QStringList pendingScanJobDirs(qint64 jobId, int limit);
+    bool recordScanJobDir(qint64 jobId, const QString& dirPath, const QStringList& files, const QStringList& subdirs);
+    QStringList scanJobFiles(qint64 jobId, qint64 fromSeq, int limit);
+    bool setScanJobState(qint64 jobId, const QString& state);
+
+    // Copies a shard's images and faces in one transaction (shard rows win per path).
+    // Shard identities join the nearest existing centroid within the usual 0.5 L2
+    // threshold, otherwise become new global_ids, so ids stay consistent across shards.
+    bool mergeShard(const QString& shardPath, ShardMergeReport& report);
+
+    // Keyset scan of (id, embedding blob) for mirroring into EmbeddingStore; canonical
+    // rows only, so faces copied from an identical file are never searched or clustered twice
+    QList<QPair<qint64, QByteArray>> embeddingsAfter(qint64 afterId, int limit);
+    qint64 faceRowCount();
+
+    // face_tombstones: (seq, face id) of deleted canonical rows, for EmbeddingStore to flag
+    QList<QPair<qint64, qint64>> tombstonesAfter(qint64 afterSeq, int limit);
+    qint64 latestTombstone();
+    bool trimTombstones(qint64 upToSeq);
+
+    // Faces of a folder (or subtree) without their blobs; vectors come from EmbeddingStore
+    QList<FaceRef> faceRefs(const QString& folderPath, bool recursive);
+    // Blob fallback for ids the store has not mirrored (yet)
+    QHash<qint64, QByteArray> embeddingsByIds(const QList<qint64>& ids);
+
+    // Per-folder identity counts, largest first, each with its exemplar's vector.
+    // Maintained with every write, so this is one indexed lookup no matter how
+    // many faces the folder holds.
+    QList<FolderPerson> folderPersonSummary(const QString& folderPath, bool recursive);
+
+    // Bumped by every write that can change faces or summaries; read it before a
+    // query to tell later whether the result is still current
+    quint64 dataVersion() const { return faceDataVersion; }
+
+    // Assigns identities to rows that have none and recomputes folder_person_summary
+    bool rebuildFolderSummaries();
+    // Rebuilds only when legacy rows lack identities or the summary was never built
+    bool ensureFolderSummaries();
+
+    // face_crops: face id -> (pack offset, byte size) in FaceCropStore's pack
+    QHash<qint64, QPair<qint64, int>> faceCropLocations(const QList<qint64>& faceIds);
+    bool addFaceCropLocations(const QList<QPair<qint64, QPair<qint64, int>>>& locations);
+
+    // Garbage collection helpers (see IndexSweeper)
+    QStringList indexedPathsAfter(const QString& afterPath, int limit);
+    int removePaths(const QStringList& paths);      // returns face rows removed
+    int purgeOrphanIdentities();
+    qint64 reclaimableBytes();
+    bool compact();
+
+    // Indexed path whose file was renamed to image.imagePath (same identity, size and mtime), or empty
+    QString findMovedImage(const ImageRecord& image);
+
+    // Bulk variants: entries and embedding blobs in a single statement (no per-face lookups)
+    QList<FaceRecord> getFaceRecordsInFolder(const QString& folderPath);
+    QList<FaceRecord> getFaceRecordsInSubtree(const QString& rootPath);
+
+    // Forward-only streaming variants: rows arrive in chunks together with their embeddings
+    bool streamFaceEntriesInFolder(const QString& folderPath, const FaceChunkCallback& onChunk, int chunkSize = 512);
+    bool streamFaceEntriesInSubtree(const QString& rootPath, const FaceChunkCallback& onChunk, int chunkSize = 512);
+
 private:
-    QSqlDatabase db;
+    QString dbFilePath;
+    SqliteProfile profile;
+    IdentityIndex identities;       // guarded by the writer lease
+    std::atomic<quint64> faceDataVersion { 0 };
+    mutable QMutex profileMutex;
+
     FaceDatabaseManager();
     void openDatabase();
-    QSqlDatabase getThreadDb();
+    void configurePool();
+    void applyConnectionProfile(QSqlDatabase& conn);
+    void addColumnIfMissing(QSqlDatabase& conn, const QString& table, const QString& column, const QString& type);
     QByteArray embeddingToBlob(const std::vector<float>& emb);
     std::vector<float> blobToEmbedding(const QByteArray& blob);
+    bool streamFaceQuery(QSqlQuery& query, const FaceChunkCallback& onChunk, int chunkSize);
+    static FaceRecord faceRecordFromRow(const QSqlQuery& query);
 };
 
 #endif // FACEDATABASEMANAGER_H
@@ -3,73 +3,99 @@
 #include <QStyle>
 #include <QStyleOptionButton>
 
+// Scaled pixmaps kept across repaints (in KB): a few screens of 256 px thumbnails
+constexpr int PIXMAP_CACHE_KB = 48 * 1024;
+constexpr int CHECKBOX_SIZE = 16;
+constexpr int LABEL_HEIGHT = 22;
+
 FaceListItemDelegate::FaceListItemDelegate(ViewMode m, QObject* parent)
-    : QStyledItemDelegate(parent), mode(m) {}
+    : QStyledItemDelegate(parent), mode(m) {
+    pixmaps.setMaxCost(PIXMAP_CACHE_KB);
+}
 
 QSize FaceListItemDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const {
-    Q_UNUSED(option);
     Q_UNUSED(index);
-    return QSize(140, 160);  // Match your grid size
+    if (mode == FaceListMode)
+        return QSize(140, 160);  // Match your grid size
+
+    // Folder view: icon plus margins and the label; follows the zoom
+    return option.decorationSize + QSize(12, 32);
+}
+
+QPixmap FaceListItemDelegate::scaledPixmap(const QModelIndex& index, const QSize& box) const {
+    QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
+    if (icon.isNull())
+        return QPixmap();
+
+    // The model hands out the same QIcon until the thumbnail changes, so its cacheKey identifies the image
+    const QPair<qint64, quint64> key(icon.cacheKey(), (quint64(box.width()) << 32) | quint32(box.height()));
+    if (const QPixmap* cached = pixmaps.object(key))
+        return *cached;
+
+    // QIcon only scales down; stand-ins from a smaller tier are scaled up here, once
+    QPixmap pixmap = icon.pixmap(box);
+    const QSize shown = pixmap.deviceIndependentSize().toSize();
+    const QSize fitted = shown.scaled(box, Qt::KeepAspectRatio);
+    if (!pixmap.isNull() && shown != fitted) {
+        pixmap = pixmap.scaled(fitted * pixmap.devicePixelRatio(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const int costKb = qMax(1, static_cast<int>(qint64(pixmap.width()) * pixmap.height() * 4 / 1024));
+    pixmaps.insert(key, new QPixmap(pixmap), costKb);
+    return pixmap;
+}
+
+FaceListItemDelegate::ItemLayout FaceListItemDelegate::layoutFor(const QStyleOptionViewItem& option,
+                                                                 const QModelIndex& index,
+                                                                 const QSize& pixmapSize) const {
+    const QRect itemRect = option.rect;
+    ItemLayout layout;
+
+    // Image centred in the space above the label
+    int iconX = itemRect.left() + (itemRect.width() - pixmapSize.width()) / 2;
+    int iconY = itemRect.top() + (itemRect.height() - pixmapSize.height() - LABEL_HEIGHT) / 2;
+    layout.imageRect = QRect(iconX, iconY, pixmapSize.width(), pixmapSize.height());
+    layout.textRect = QRect(itemRect.left(), itemRect.bottom() - LABEL_HEIGHT, itemRect.width(), 20);
+
+    // Face list: always a checkbox; folder view: only for user-checkable items
+    bool withCheckbox = mode == FaceListMode || (index.flags() & Qt::ItemIsUserCheckable);
+    if (withCheckbox) {
+        layout.checkRect = QRect(layout.imageRect.right() - CHECKBOX_SIZE - 4, layout.imageRect.top() + 4,
+                                 CHECKBOX_SIZE, CHECKBOX_SIZE);
+    }
+    return layout;
 }
 
 void FaceListItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
                                  const QModelIndex& index) const {
     painter->save();
-    QRect itemRect = option.rect;
 
     // === 1. Selection highlight
     if (option.state & QStyle::State_Selected) {
         painter->setPen(QPen(QColor(100, 150, 255), 2));
-        painter->drawRect(itemRect.adjusted(1, 1, -2, -2));
+        painter->drawRect(option.rect.adjusted(1, 1, -2, -2));
     }
 
-    // === 2. Get icon and draw it
-    QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
-    QSize iconSize = option.decorationSize;
-    QPixmap pixmap = icon.pixmap(iconSize);
-    QSize actualSize = pixmap.size().scaled(iconSize, Qt::KeepAspectRatio);
-
-    int iconX = itemRect.left() + (itemRect.width() - actualSize.width()) / 2;
-    int iconY = itemRect.top() + (itemRect.height() - actualSize.height() - 22) / 2;
-    QRect imageRect(iconX, iconY, actualSize.width(), actualSize.height());
-    painter->drawPixmap(imageRect, pixmap);
+    // === 2. Pre-scaled icon: drawn 1:1, no per-paint scaling
+    const QPixmap pixmap = scaledPixmap(index, option.decorationSize);
+    const ItemLayout layout = layoutFor(option, index, pixmap.deviceIndependentSize().toSize());
+    if (!pixmap.isNull())
+        painter->drawPixmap(layout.imageRect.topLeft(), pixmap);
 
     // === 3. Draw text label (e.g. "Person 1")
-    QString text = index.data(Qt::DisplayRole).toString();
-    QRect textRect(itemRect.left(), itemRect.bottom() - 22, itemRect.width(), 20);
-    painter->drawText(textRect, Qt::AlignCenter, text);
-
-    // === 4. Draw checkbox if needed
-    bool shouldDrawCheckbox = false;
-    Qt::CheckState checkState = Qt::Unchecked;
-
-    if (mode == FaceListMode) {
-        shouldDrawCheckbox = true;
-    } else if (mode == FolderViewMode) {
-        shouldDrawCheckbox = index.flags() & Qt::ItemIsUserCheckable;
-    }
+    painter->drawText(layout.textRect, Qt::AlignCenter, index.data(Qt::DisplayRole).toString());
 
-    if (shouldDrawCheckbox) {
-        checkState = static_cast<Qt::CheckState>(index.data(Qt::CheckStateRole).toInt());
+    // === 4. Checkbox inside the image, where editorEvent() looks for clicks
+    if (!layout.checkRect.isEmpty()) {
+        Qt::CheckState checkState = static_cast<Qt::CheckState>(index.data(Qt::CheckStateRole).toInt());
 
         QStyleOptionButton checkboxOption;
         checkboxOption.state = QStyle::State_Enabled |
                                (checkState == Qt::Checked ? QStyle::State_On : QStyle::State_Off);
-
-        // ✅ Draw checkbox inside the imageRect (not full itemRect)
-        const int checkboxSize = 16;
-        QRect checkRect(
-            imageRect.right() - checkboxSize - 4,
-            imageRect.top() + 4,
-            checkboxSize,
-            checkboxSize
-            );
-
-        checkboxOption.rect = checkRect;
+        checkboxOption.rect = layout.checkRect;
         QApplication::style()->drawControl(QStyle::CE_CheckBox, &checkboxOption, painter);
     }
 
-
     painter->restore();
 }
 
@@ -80,34 +106,17 @@ bool FaceListItemDelegate::editorEvent(QEvent* event, QAbstractItemModel* model,
 
     if (event->type() == QEvent::MouseButtonRelease) {
         QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
-        QRect itemRect = option.rect;
-
-        // === Recompute imageRect same as in paint()
-        QIcon icon = qvariant_cast<QIcon>(index.data(Qt::DecorationRole));
-        QSize iconSize = option.decorationSize;
-        QPixmap pixmap = icon.pixmap(iconSize);
-        QSize actualSize = pixmap.size().scaled(iconSize, Qt::KeepAspectRatio);
-
-        int iconX = itemRect.left() + (itemRect.width() - actualSize.width()) / 2;
-        int iconY = itemRect.top() + 8;
-        QRect imageRect(iconX, iconY, actualSize.width(), actualSize.height());
-
-        // === Define checkboxRect based on imageRect
-        const int checkboxSize = 16;
-        QRect checkboxRect(
-            imageRect.right() - checkboxSize - 4,
-            imageRect.top() + 4,
-            checkboxSize,
-            checkboxSize
-            );
-
-        if (checkboxRect.contains(mouseEvent->pos())) {
+
+        // ✅ Same layout as paint(): the pixmap was scaled for the last repaint, so this is a cache hit
+        const QPixmap pixmap = scaledPixmap(index, option.decorationSize);
+        const ItemLayout layout = layoutFor(option, index, pixmap.deviceIndependentSize().toSize());
+
+        if (layout.checkRect.contains(mouseEvent->pos())) {
             Qt::CheckState current = static_cast<Qt::CheckState>(index.data(Qt::CheckStateRole).toInt());
             model->setData(index, current == Qt::Checked ? Qt::Unchecked : Qt::Checked, Qt::CheckStateRole);
             return true;
         }
     }
 
-
     return false;
 }
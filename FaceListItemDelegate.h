@@ -7,6 +7,8 @@
 #include <QStyleOptionViewItem>
 #include <QMouseEvent>
 #include <QEvent>
+#include <QCache>
+#include <QPixmap>
 #include "FaceTypes.h"
 
 class FaceListItemDelegate : public QStyledItemDelegate {
@@ -26,7 +28,20 @@ public:
     QList<FaceEntry> getFaceEntriesInSubtree(const QString& rootPath);
 
 private:
+    // Where everything of one item goes; paint() and editorEvent() both use layoutFor()
+    struct ItemLayout {
+        QRect imageRect;
+        QRect textRect;
+        QRect checkRect;    // empty without a checkbox
+    };
+
+    ItemLayout layoutFor(const QStyleOptionViewItem& option, const QModelIndex& index, const QSize& pixmapSize) const;
+
+    // The item's icon already scaled to the decoration size; built once per icon and size
+    QPixmap scaledPixmap(const QModelIndex& index, const QSize& box) const;
+
     ViewMode mode;
+    mutable QCache<QPair<qint64, quint64>, QPixmap> pixmaps;   // (icon cacheKey, box) -> pixmap, cost in KB
 };
 
 #endif // FACELISTITEMDELEGATE_H
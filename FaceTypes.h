@@ -3,6 +3,10 @@
 
 #include <QString>
 #include <QRect>
+#include <QByteArray>
+#include <QList>
+#include <vector>
+#include <functional>
 
 // Unified structure for face metadata used in DB, UI, and logic
 struct FaceEntry {
@@ -13,4 +17,47 @@ struct FaceEntry {
     float quality = 0.0f;   // Focus/sharpness score
 };
 
+// Per-file index record; the content hash lets identical files share results
+struct ImageRecord {
+    QString imagePath;
+    qint64 mtime = 0;
+    qint64 fileSize = 0;
+    QString contentHash;    // size + sampled blocks (see ImageFingerprint.h)
+    QString fullHash;       // whole-file hash, only filled in on a quick-hash collision
+    QString fileId;         // device + inode, used to recognise external renames
+};
+
+// Non-owning view over an embedding stored in a row buffer (no copy into std::vector)
+struct EmbeddingView {
+    const float* data = nullptr;
+    size_t size = 0;
+
+    const float* begin() const { return data; }
+    const float* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    std::vector<float> toVector() const { return std::vector<float>(begin(), end()); }
+};
+
+// Face metadata plus its raw embedding blob, fetched in the same row
+struct FaceRecord {
+    FaceEntry entry;
+    QByteArray embeddingBlob;   // implicitly shared with the query result, not copied
+
+    EmbeddingView embedding() const {
+        return { reinterpret_cast<const float*>(embeddingBlob.constData()),
+                 static_cast<size_t>(embeddingBlob.size()) / sizeof(float) };
+    }
+};
+
+// Face row without its vector, for matching against EmbeddingStore
+struct FaceRef {
+    qint64 id = 0;
+    qint64 embeddingId = 0;     // row that owns the vector: copies of an identical file share their original's
+    QString imagePath;
+    QString globalId;
+};
+
+// Receives one chunk of a streamed face query; return false to stop iterating
+using FaceChunkCallback = std::function<bool(const QList<FaceRecord>& records)>;
+
 #endif // FACETYPES_H
@@ -0,0 +1,280 @@
+#include "FaceWriteQueue.h"
+#include "FaceDatabaseManager.h"
+#include "EmbeddingStore.h"
+#include <QThread>
+#include <QDebug>
+#include <utility>
+
+constexpr int COMMIT_ATTEMPTS = 3;
+constexpr int RETRY_DELAY_MS = 250;
+constexpr int RETRY_ROUNDS = 3;             // commit rounds a failed group gets before it is dropped
+constexpr int RETRY_INTERVAL_MS = 2000;
+constexpr int MAX_DROPPED_RANGES = 256;
+
+FaceWriteQueue& FaceWriteQueue::instance() {
+    static FaceWriteQueue inst;
+    return inst;
+}
+
+FaceWriteQueue::FaceWriteQueue() {
+    start(QThread::LowPriority);
+}
+
+FaceWriteQueue::~FaceWriteQueue() {
+    shutdown();
+}
+
+quint64 FaceWriteQueue::enqueue(const ImageRecord& image, const QList<FaceEntry>& entries,
+                                const QList<std::vector<float>>& embeddings, const QList<QByteArray>& crops) {
+    ImageWrite write;
+    write.image = image;
+    write.entries = entries;
+    write.embeddings = embeddings;
+    write.crops = crops;
+    return enqueueWrite(std::move(write));
+}
+
+quint64 FaceWriteQueue::enqueueClone(const ImageRecord& image, const QString& sourcePath) {
+    ImageWrite write;
+    write.image = image;
+    write.cloneFromPath = sourcePath;
+    return enqueueWrite(std::move(write));
+}
+
+quint64 FaceWriteQueue::enqueueCheckpoint(qint64 jobId, qint64 watermark) {
+    PendingBatch batch;
+    batch.checkpoint.jobId = jobId;
+    batch.checkpoint.watermark = watermark;
+    return enqueueBatch(std::move(batch), 0);
+}
+
+quint64 FaceWriteQueue::enqueueWrite(ImageWrite&& write) {
+    PendingBatch batch;
+    int rows = qMax(1, static_cast<int>(write.entries.size()));
+    batch.write = std::move(write);
+    return enqueueBatch(std::move(batch), rows);
+}
+
+quint64 FaceWriteQueue::enqueueBatch(PendingBatch&& batch, int rows) {
+    QMutexLocker locker(&mutex);
+
+    batch.seq = ++lastEnqueuedSeq;
+
+    // Writer already gone (e.g. a worker finishing after shutdown): write it here rather than drop it
+    if (stopped) {
+        QList<PendingBatch> batches { std::move(batch) };
+        recordCommit(batches, 0, commitBatches(batches, taintedJobs));
+        return lastEnqueuedSeq;
+    }
+
+    const bool wasEmpty = queue.isEmpty();
+    if (wasEmpty)
+        oldestPending.start();
+    pendingRows += rows;
+    queue.enqueue(std::move(batch));
+
+    // Empty -> non-empty starts the age timer the writer sleeps on; a full batch goes right away
+    if (wasEmpty || pendingRows >= maxRows)
+        workAvailable.wakeOne();
+
+    return lastEnqueuedSeq;
+}
+
+quint64 FaceWriteQueue::mark() {
+    QMutexLocker locker(&mutex);
+    return lastEnqueuedSeq;
+}
+
+quint64 FaceWriteQueue::beginJob(qint64 jobId) {
+    QMutexLocker locker(&mutex);
+    activeJobs.insert(jobId);
+    taintedJobs.remove(jobId);
+    return lastEnqueuedSeq;
+}
+
+void FaceWriteQueue::endJob(qint64 jobId) {
+    QMutexLocker locker(&mutex);
+    activeJobs.remove(jobId);
+    taintedJobs.remove(jobId);
+}
+
+bool FaceWriteQueue::flush() {
+    quint64 seq, since;
+    {
+        QMutexLocker locker(&mutex);
+        seq = lastEnqueuedSeq;
+        since = reportedSeq;
+    }
+    const bool ok = waitFor(seq, since);
+
+    // ✅ Reported now: later plain fences only hear about losses after this one
+    if (!ok) {
+        QMutexLocker locker(&mutex);
+        reportedSeq = qMax(reportedSeq, seq);
+    }
+    return ok;
+}
+
+bool FaceWriteQueue::flush(quint64 since) {
+    return waitFor(mark(), since);
+}
+
+bool FaceWriteQueue::waitFor(quint64 seq, quint64 since) {
+    QMutexLocker locker(&mutex);
+    if (seq > lastWrittenSeq && !stopped) {
+        flushRequestedSeq = qMax(flushRequestedSeq, seq);
+        workAvailable.wakeOne();
+
+        while (lastWrittenSeq < seq && !stopped)
+            committed.wait(&mutex);
+    }
+    return !droppedBetween(since, seq);
+}
+
+bool FaceWriteQueue::droppedBetween(quint64 since, quint64 seq) const {
+    for (const DroppedRange& range : dropped) {
+        if (range.first <= seq && range.last > since)
+            return true;
+    }
+    return false;
+}
+
+void FaceWriteQueue::setCommitPolicy(int rows, int delayMs) {
+    QMutexLocker locker(&mutex);
+    maxRows = qMax(1, rows);
+    maxDelayMs = qMax(0, delayMs);
+    workAvailable.wakeOne();
+}
+
+void FaceWriteQueue::shutdown() {
+    {
+        QMutexLocker locker(&mutex);
+        if (stopping) return;
+        stopping = true;
+        workAvailable.wakeOne();
+    }
+    wait();
+}
+
+void FaceWriteQueue::run() {
+    while (true) {
+        QList<PendingBatch> batches;
+        QSet<qint64> skipCheckpointsOf;
+        int retried = 0;
+        {
+            QMutexLocker locker(&mutex);
+
+            // Sleep until a due retry, a size/time threshold, a flush request or shutdown
+            while (!stopping) {
+                // A failed group goes first, so nothing commits before its retry is due
+                if (!retrying.isEmpty()) {
+                    qint64 retryIn = RETRY_INTERVAL_MS - retryClock.elapsed();
+                    if (retryIn <= 0)
+                        break;
+                    workAvailable.wait(&mutex, retryIn);
+                    continue;
+                }
+
+                bool flushWanted = flushRequestedSeq > lastWrittenSeq;
+                bool sizeReached = pendingRows >= maxRows;
+                bool ageReached = !queue.isEmpty() && oldestPending.elapsed() >= maxDelayMs;
+                if (flushWanted || sizeReached || ageReached)
+                    break;
+
+                // Nothing queued: enqueue() wakes us on the first write
+                if (queue.isEmpty())
+                    workAvailable.wait(&mutex);
+                else
+                    workAvailable.wait(&mutex, qMax<qint64>(1, maxDelayMs - oldestPending.elapsed()));
+            }
+
+            if (queue.isEmpty() && retrying.isEmpty()) {
+                if (!stopping) continue;
+                stopped = true;  // later enqueues commit on their own thread
+                committed.wakeAll();
+                break;
+            }
+
+            // ✅ Retries first, in one transaction with what follows: an older write never lands after a newer one
+            batches = std::exchange(retrying, {});
+            retried = batches.size();
+            while (!queue.isEmpty())
+                batches.append(queue.dequeue());
+            pendingRows = 0;
+            skipCheckpointsOf = taintedJobs;
+        }
+
+        bool ok = commitBatches(batches, skipCheckpointsOf);
+
+        QMutexLocker locker(&mutex);
+        recordCommit(batches, retried, ok);
+    }
+}
+
+bool FaceWriteQueue::commitBatches(const QList<PendingBatch>& batches, const QSet<qint64>& skipCheckpointsOf) {
+    // ✅ One transaction for every image collected since the last commit; copies, so a failure can be retried
+    QList<ImageWrite> writes;
+    QList<ScanCheckpoint> checkpoints;
+    writes.reserve(batches.size());
+    int skippedCheckpoints = 0;
+    for (const PendingBatch& b : batches) {
+        if (b.checkpoint.jobId == 0)
+            writes.append(b.write);
+        else if (!skipCheckpointsOf.contains(b.checkpoint.jobId))
+            checkpoints.append(b.checkpoint);
+        else
+            ++skippedCheckpoints;
+    }
+
+    // Some of the job's writes were dropped: a watermark past them would make resume skip those files
+    if (skippedCheckpoints > 0)
+        qWarning() << "⚠️ Not advancing" << skippedCheckpoints << "scan checkpoint(s) of a job that lost writes";
+
+    // A busy or briefly locked database usually clears up; the transaction is all-or-nothing, so retrying is safe
+    for (int attempt = 1; attempt <= COMMIT_ATTEMPTS; ++attempt) {
+        if (FaceDatabaseManager::instance().commitImageWrites(writes, checkpoints)) {
+            qDebug() << "💾 Group commit:" << writes.size() << "image(s)";
+            EmbeddingStore::instance().scheduleCatchUp();  // mirror the new vectors on the store's thread
+            return true;
+        }
+        qWarning() << "⚠️ Group commit attempt" << attempt << "of" << COMMIT_ATTEMPTS << "failed for" << writes.size() << "image(s)";
+        if (attempt < COMMIT_ATTEMPTS)
+            QThread::msleep(RETRY_DELAY_MS * attempt);
+    }
+
+    qWarning() << "❌ Group commit failed for" << writes.size() << "image(s)";
+    return false;
+}
+
+void FaceWriteQueue::recordCommit(const QList<PendingBatch>& batches, int retried, bool ok) {
+    if (ok) {
+        retryRounds = 0;
+        lastWrittenSeq = batches.last().seq;
+        committed.wakeAll();
+        return;
+    }
+
+    // Kept for another round unless the retried part is out of rounds (or the writer is going away)
+    int drop = 0;
+    if (stopping || stopped)
+        drop = batches.size();
+    else if (retried > 0 && retryRounds >= RETRY_ROUNDS)
+        drop = retried;     // what only joined them this round gets rounds of its own
+
+    if (drop > 0) {
+        dropped.append({ batches.first().seq, batches[drop - 1].seq });
+        while (dropped.size() > MAX_DROPPED_RANGES)
+            dropped.removeFirst();
+        taintedJobs.unite(activeJobs);
+        qWarning() << "❌ Dropped" << drop << "queued write(s) after" << retryRounds << "retry round(s); they are not in the index";
+    }
+
+    retrying = batches.mid(drop);
+    retryRounds = retrying.isEmpty() ? 0 : (drop > 0 ? 1 : retryRounds + 1);
+    if (!retrying.isEmpty())
+        retryClock.start();
+
+    // ✅ Fences wait for writes still being retried; everything before them is settled
+    lastWrittenSeq = retrying.isEmpty() ? batches.last().seq : retrying.first().seq - 1;
+    committed.wakeAll();
+}
@@ -0,0 +1,110 @@
+#ifndef FACEWRITEQUEUE_H
+#define FACEWRITEQUEUE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QSet>
+#include <QElapsedTimer>
+#include <vector>
+#include "FaceTypes.h"
+#include "FaceDatabaseManager.h"
+
+// Write-behind queue: scan threads enqueue faces without touching SQLite,
+// a single writer thread group-commits them in large transactions.
+//
+// A group commit that fails (after a few quick attempts) is kept and retried,
+// in order and ahead of newer writes, for a few more commit rounds; fences
+// covering it wait for the outcome. Only writes that keep failing are dropped.
+// A dropped range is reported to the fences whose range covers it: a scoped
+// flush(since) sees it whenever since lies before it, a plain flush() only
+// until one plain fence has reported it. Scan jobs registered with
+// beginJob() when writes are dropped stop writing checkpoints, so their
+// watermark never moves past the lost files; jobs started later are not
+// affected. After shutdown() the caller's thread commits each enqueued
+// write itself.
+class FaceWriteQueue : public QThread {
+public:
+    static FaceWriteQueue& instance();
+
+    // Non-blocking; returns a sequence number usable with waitFor()
+    quint64 enqueue(const ImageRecord& image, const QList<FaceEntry>& entries,
+                    const QList<std::vector<float>>& embeddings, const QList<QByteArray>& crops = {});
+
+    // Records an identical copy of an already analysed file without re-detecting it
+    quint64 enqueueClone(const ImageRecord& image, const QString& sourcePath);
+
+    // Advances a scan job's watermark in the same transaction as everything enqueued before it
+    quint64 enqueueCheckpoint(qint64 jobId, qint64 watermark);
+
+    // Fence: blocks until everything enqueued before the call was written;
+    // false if any of it was dropped and no earlier plain flush() reported that
+    bool flush();
+    // Same, but false if anything enqueued after `since` (a mark()) was dropped
+    bool flush(quint64 since);
+    bool waitFor(quint64 seq, quint64 since);
+
+    // Sequence number of the latest enqueued write, for scoping flush(since)
+    quint64 mark();
+
+    // A scan job's checkpoints stop once writes are dropped while it runs; returns mark()
+    quint64 beginJob(qint64 jobId);
+    void endJob(qint64 jobId);
+
+    // Commit once this many rows are pending or the oldest one is this old
+    void setCommitPolicy(int maxRows, int maxDelayMs);
+
+    // Flushes pending work and joins the writer thread
+    void shutdown();
+
+protected:
+    void run() override;
+
+private:
+    struct PendingBatch {
+        quint64 seq = 0;
+        ImageWrite write;
+        ScanCheckpoint checkpoint;  // jobId 0 = plain image write
+    };
+
+    quint64 enqueueWrite(ImageWrite&& write);
+    quint64 enqueueBatch(PendingBatch&& batch, int rows);
+    static bool commitBatches(const QList<PendingBatch>& batches, const QSet<qint64>& skipCheckpointsOf);
+    void recordCommit(const QList<PendingBatch>& batches, int retried, bool ok);  // mutex held
+    bool droppedBetween(quint64 since, quint64 seq) const;                         // mutex held
+
+    struct DroppedRange {
+        quint64 first = 0;
+        quint64 last = 0;
+    };
+
+    FaceWriteQueue();
+    ~FaceWriteQueue() override;
+
+    QMutex mutex;
+    QWaitCondition workAvailable;
+    QWaitCondition committed;
+    QQueue<PendingBatch> queue;
+    QElapsedTimer oldestPending;
+
+    int pendingRows = 0;
+    int maxRows = 2000;
+    int maxDelayMs = 500;
+    quint64 lastEnqueuedSeq = 0;
+    quint64 lastWrittenSeq = 0;     // every seq up to here is settled: committed or dropped
+    quint64 flushRequestedSeq = 0;
+
+    QList<PendingBatch> retrying;   // failed group commit, retried ahead of newer writes
+    int retryRounds = 0;
+    QElapsedTimer retryClock;
+    QList<DroppedRange> dropped;    // writes given up on, oldest first (bounded)
+    quint64 reportedSeq = 0;        // plain flush() only looks past this
+    QSet<qint64> activeJobs;
+    QSet<qint64> taintedJobs;       // active when writes were dropped: no more checkpoints
+    bool stopping = false;
+    bool stopped = false;           // writer thread has exited
+};
+
+#endif // FACEWRITEQUEUE_H
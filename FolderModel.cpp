@@ -0,0 +1,423 @@
+#include "FolderModel.h"
+
+#include <QFileInfo>
+#include <QFileIconProvider>
+#include <QApplication>
+#include <QStyle>
+#include <QPixmap>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QDebug>
+#include <algorithm>
+
+constexpr int MTIME_BATCH = 256;
+constexpr int PROBE_BATCH = 32;
+
+// Worker -> GUI thread hand-off that may outlive the model: runs only if it still exists
+template <typename Apply>
+static void postTo(const QPointer<FolderModel>& model, Apply apply) {
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [model, apply]() {
+        if (model)
+            apply(model.data());
+    }, Qt::QueuedConnection);
+}
+
+FolderModel::FolderModel(QObject* parent) : QAbstractListModel(parent) {
+    // One icon for every folder instead of a provider lookup per entry
+    QFileIconProvider provider;
+    folderIcon = provider.icon(QFileIconProvider::Folder);
+    placeholderIcon = QIcon(":/icons/placeholder.png");
+    failedIcon = QApplication::style()->standardIcon(QStyle::SP_MessageBoxWarning);
+}
+
+FolderModel::~FolderModel() {
+    ++*generation;  // running workers stop at their next check
+}
+
+void FolderModel::setDirectory(const QString& path) {
+    const quint64 listing = ++*generation;
+
+    beginResetModel();
+    dirPath = path;
+    dirMtime = 0;
+    entries.clear();
+    hiddenFolders.clear();
+    rowByPath.clear();
+    fetched = 0;
+    runningWorkers = 0;
+    listingChanged = false;
+    listingStale = false;
+    endResetModel();
+
+    QPointer<FolderModel> self(this);
+    QFuture<void> _ = QtConcurrent::run([self, current = generation, path, listing]() {
+        QElapsedTimer timer;
+        timer.start();
+        bool fromCache = false;
+        DirectoryListing listed = DirectoryCache::instance().list(path, &fromCache);
+        if (listing != *current) return;
+
+        qDebug() << "📂 Listed" << listed.entries.size() << "entries of" << path << (fromCache ? "from cache" : "from disk")
+                 << "in" << timer.elapsed() << "ms";
+        postTo(self, [listing, listed, fromCache](FolderModel* model) {
+            model->applyListing(listing, listed, fromCache);
+        });
+    });
+}
+
+void FolderModel::applyListing(quint64 listing, const DirectoryListing& listed, bool fromCache) {
+    if (listing != *generation) return;
+
+    dirMtime = listed.dirMtime;
+    listingChanged = !fromCache;
+
+    const QString prefix = dirPath.endsWith('/') ? dirPath : dirPath + "/";
+    QStringList files;
+    QVector<FolderProbe> dirs;
+    entries.reserve(listed.entries.size());
+    for (const DirectoryEntry& d : listed.entries) {
+        FolderEntry e;
+        e.name = d.name;
+        e.path = prefix + d.name;
+        e.isDir = d.isDir;
+        e.mtime = d.mtime;
+        e.content = d.content;
+
+        if (e.isDir)
+            dirs.append({ e.path, e.content, e.mtime });
+        else if (e.mtime == 0)
+            files << e.path;
+
+        if (e.isDir && e.content == DirectoryEntry::ContentOther)
+            hiddenFolders.insert(e.path, e);  // ⛔ only non-image files last time
+        else
+            entries.append(std::move(e));
+    }
+    rebuildRowIndex();
+    fetchMore(QModelIndex());  // first page now, the rest as the view scrolls
+
+    runningWorkers = 2;
+    QPointer<FolderModel> self(this);
+
+    // Missing file mtimes in row order, for the listing cache; thumbnail jobs stat their own file
+    const QString folder = dirPath;
+    QFuture<void> mtimes = QtConcurrent::run([self, current = generation, folder, files, listing]() {
+        QVector<QPair<QString, qint64>> batch;
+        for (int i = 0; i < files.size(); ++i) {
+            if (listing != *current) return;
+            batch.append({ files[i], QFileInfo(files[i]).lastModified().toMSecsSinceEpoch() });
+            if (batch.size() == MTIME_BATCH || i == files.size() - 1) {
+                postTo(self, [listing, batch](FolderModel* model) { model->applyMtimes(listing, batch); });
+                batch.clear();
+            }
+        }
+        const qint64 after = DirectoryCache::folderMtime(folder);
+        postTo(self, [listing, after](FolderModel* model) { model->workerFinished(listing, after); });
+    });
+
+    // Which subfolders hold images; a folder whose mtime is unchanged keeps its last answer
+    QFuture<void> probes = QtConcurrent::run([self, current = generation, folder, dirs, listing]() {
+        QVector<FolderProbe> batch;
+        for (int i = 0; i < dirs.size(); ++i) {
+            if (listing != *current) return;
+            const FolderProbe& known = dirs[i];
+            qint64 mtime = DirectoryCache::folderMtime(known.path);
+            if (mtime != known.mtime || known.content == DirectoryEntry::ContentUnknown)
+                batch.append({ known.path, static_cast<quint8>(DirectoryCache::probeFolder(known.path)), mtime });
+
+            if (!batch.isEmpty() && (batch.size() == PROBE_BATCH || i == dirs.size() - 1)) {
+                postTo(self, [listing, batch](FolderModel* model) { model->applyContent(listing, batch); });
+                batch.clear();
+            }
+        }
+        const qint64 after = DirectoryCache::folderMtime(folder);
+        postTo(self, [listing, after](FolderModel* model) { model->workerFinished(listing, after); });
+    });
+}
+
+void FolderModel::applyMtimes(quint64 listing, const QVector<QPair<QString, qint64>>& mtimes) {
+    if (listing != *generation) return;
+
+    int first = fetched, last = -1;
+    for (const auto& m : mtimes) {
+        int row = rowByPath.value(m.first, -1);
+        if (row < 0) continue;
+        FolderEntry& e = entries[row];
+        if (e.thumbnailFailed && e.mtime != 0 && e.mtime != m.second) {
+            e.thumbnailFailed = false;  // rewritten since the failed decode: worth another try
+            e.thumbnailLoaded = false;
+        }
+        e.mtime = m.second;
+        if (row < fetched) {
+            first = qMin(first, row);
+            last = qMax(last, row);
+        }
+    }
+    listingChanged = true;
+    if (last >= first)
+        emit dataChanged(index(first), index(last), { ModifiedRole });
+    emit entriesUpdated();
+}
+
+void FolderModel::applyContent(quint64 listing, const QVector<FolderProbe>& probes) {
+    if (listing != *generation) return;
+
+    listingChanged = true;
+    QList<int> hidden;
+    for (const FolderProbe& probe : probes) {
+        const bool onlyOther = probe.content == DirectoryEntry::ContentOther;
+
+        auto h = hiddenFolders.find(probe.path);
+        if (h != hiddenFolders.end()) {
+            h->content = probe.content;
+            h->mtime = probe.mtime;
+            if (!onlyOther) {
+                FolderEntry folder = h.value();
+                hiddenFolders.erase(h);
+                showFolder(folder);  // images showed up
+            }
+            continue;
+        }
+
+        int row = rowByPath.value(probe.path, -1);
+        if (row < 0) continue;
+        entries[row].content = probe.content;
+        entries[row].mtime = probe.mtime;
+        if (onlyOther)
+            hidden << row;  // ⛔ only non-image files
+    }
+    hideRows(hidden);
+}
+
+void FolderModel::hideRows(QList<int> rows) {
+    if (rows.isEmpty()) return;
+
+    for (int row : rows)
+        hiddenFolders.insert(entries[row].path, entries[row]);
+
+    // Remove from the bottom up in contiguous runs so earlier rows keep their numbers
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    for (int i = 0; i < rows.size();) {
+        int last = rows[i];
+        int first = last;
+        while (++i < rows.size() && rows[i] == first - 1)
+            first = rows[i];
+
+        if (first < fetched) {
+            int visibleLast = qMin(last, fetched - 1);
+            beginRemoveRows(QModelIndex(), first, visibleLast);
+            entries.remove(first, last - first + 1);
+            fetched -= visibleLast - first + 1;
+            endRemoveRows();
+        } else {
+            entries.remove(first, last - first + 1);
+        }
+    }
+    rebuildRowIndex();
+}
+
+void FolderModel::showFolder(const FolderEntry& folder) {
+    // Folders come first, in case-folded name order
+    const QString key = folder.name.toCaseFolded();
+    int row = 0;
+    while (row < entries.size() && entries[row].isDir && entries[row].name.toCaseFolded() < key)
+        ++row;
+
+    if (row <= fetched) {
+        beginInsertRows(QModelIndex(), row, row);
+        entries.insert(row, folder);
+        ++fetched;
+        endInsertRows();
+    } else {
+        entries.insert(row, folder);
+    }
+    rebuildRowIndex();
+}
+
+void FolderModel::workerFinished(quint64 listing, qint64 dirMtimeAfter) {
+    if (listing != *generation) return;
+
+    // Changed while it was being completed (stat'd by the worker, not here): the next visit lists it again
+    if (dirMtimeAfter != dirMtime)
+        listingStale = true;
+    if (--runningWorkers > 0) return;
+
+    // ✅ Completed listing back to the cache: the next visit needs no stats at all
+    if (listingChanged && !listingStale)
+        DirectoryCache::instance().store(completedListing());
+}
+
+DirectoryListing FolderModel::completedListing() const {
+    DirectoryListing listing;
+    listing.path = dirPath;
+    listing.dirMtime = dirMtime;
+
+    auto toEntry = [](const FolderEntry& e) {
+        DirectoryEntry d;
+        d.name = e.name;
+        d.isDir = e.isDir;
+        d.mtime = e.mtime;
+        d.content = e.content;
+        return d;
+    };
+
+    // Hidden folders go back between the visible ones, in the same order as a fresh listing
+    QVector<DirectoryEntry> dirs;
+    int firstFile = 0;
+    for (; firstFile < entries.size() && entries[firstFile].isDir; ++firstFile)
+        dirs.append(toEntry(entries[firstFile]));
+    for (const FolderEntry& hidden : hiddenFolders)
+        dirs.append(toEntry(hidden));
+    if (!hiddenFolders.isEmpty()) {
+        std::sort(dirs.begin(), dirs.end(), [](const DirectoryEntry& a, const DirectoryEntry& b) {
+            return a.name.toCaseFolded() < b.name.toCaseFolded();
+        });
+    }
+
+    listing.entries = dirs;
+    listing.entries.reserve(listing.entries.size() + entries.size() - firstFile);
+    for (int i = firstFile; i < entries.size(); ++i)
+        listing.entries.append(toEntry(entries[i]));
+    return listing;
+}
+
+void FolderModel::rebuildRowIndex() {
+    rowByPath.clear();
+    rowByPath.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i)
+        rowByPath.insert(entries[i].path, i);
+}
+
+int FolderModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : fetched;
+}
+
+bool FolderModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && fetched < entries.size();
+}
+
+void FolderModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) return;
+
+    int count = qMin(fetchBatch, static_cast<int>(entries.size()) - fetched);
+    if (count <= 0) return;
+
+    beginInsertRows(QModelIndex(), fetched, fetched + count - 1);
+    fetched += count;
+    endInsertRows();
+    emit entriesUpdated();
+}
+
+QVariant FolderModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= fetched)
+        return QVariant();
+
+    const FolderEntry& e = entries[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+        return e.name;
+    case Qt::DecorationRole:
+        if (e.isDir) return folderIcon;
+        if (e.thumbnailFailed) return failedIcon;
+        return e.thumbnail.isNull() ? placeholderIcon : e.thumbnail;
+    case Qt::ToolTipRole:
+    case PathRole:
+        return e.path;
+    case Qt::CheckStateRole:
+        return e.checkable ? QVariant(static_cast<int>(e.check)) : QVariant();
+    case ThumbnailLoadedRole:
+        return e.thumbnailLoaded;
+    case ModifiedRole:
+        return e.mtime;
+    case IsDirRole:
+        return e.isDir;
+    default:
+        return QVariant();
+    }
+}
+
+bool FolderModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if (!index.isValid() || index.row() >= fetched || role != Qt::CheckStateRole)
+        return false;
+
+    FolderEntry& e = entries[index.row()];
+    if (!e.checkable) return false;
+    e.check = static_cast<Qt::CheckState>(value.toInt());
+    emit dataChanged(index, index, { Qt::CheckStateRole });
+    return true;
+}
+
+Qt::ItemFlags FolderModel::flags(const QModelIndex& index) const {
+    if (!index.isValid() || index.row() >= fetched)
+        return Qt::NoItemFlags;
+
+    Qt::ItemFlags f = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (entries[index.row()].checkable)
+        f |= Qt::ItemIsUserCheckable;
+    return f;
+}
+
+int FolderModel::rowOf(const QString& path) const {
+    int row = rowByPath.value(path, -1);
+    return row < fetched ? row : -1;
+}
+
+QString FolderModel::pathAt(int row) const {
+    return row >= 0 && row < fetched ? entries[row].path : QString();
+}
+
+QStringList FolderModel::imagePaths() const {
+    QStringList paths;
+    paths.reserve(entries.size());
+    for (const FolderEntry& e : entries) {
+        if (!e.isDir)
+            paths << e.path;
+    }
+    return paths;
+}
+
+void FolderModel::setThumbnail(const QString& path, const QImage& image, bool exact) {
+    int row = rowByPath.value(path, -1);
+    if (row < 0) return;
+
+    FolderEntry& e = entries[row];
+    const int edge = qMax(image.width(), image.height());
+    if (!exact && (e.thumbnailLoaded || e.thumbnailEdge >= edge))
+        return;
+
+    e.thumbnail = QIcon(QPixmap::fromImage(image));
+    e.thumbnailEdge = edge;
+    e.thumbnailLoaded = exact;
+    e.thumbnailFailed = false;
+    if (row < fetched)
+        emit dataChanged(index(row), index(row), { Qt::DecorationRole, ThumbnailLoadedRole });
+}
+
+void FolderModel::setThumbnailFailed(const QString& path) {
+    int row = rowByPath.value(path, -1);
+    if (row < 0) return;
+
+    FolderEntry& e = entries[row];
+    e.thumbnailFailed = true;
+    e.thumbnailLoaded = true;
+    if (row < fetched)
+        emit dataChanged(index(row), index(row), { Qt::DecorationRole, ThumbnailLoadedRole });
+}
+
+void FolderModel::invalidateThumbnails() {
+    // The old thumbnail stays on screen until its replacement arrives; a failed decode fails at every tier
+    for (FolderEntry& e : entries)
+        e.thumbnailLoaded = e.thumbnailFailed;
+}
+
+void FolderModel::setMatchedFiles(const QSet<QString>& matched) {
+    for (FolderEntry& e : entries) {
+        if (e.isDir) continue;
+        // Always allow user to manually check/uncheck
+        e.checkable = true;
+        e.check = matched.contains(e.name) ? Qt::Checked : Qt::Unchecked;
+    }
+    if (fetched > 0)
+        emit dataChanged(index(0), index(fetched - 1), { Qt::CheckStateRole });
+}
@@ -0,0 +1,126 @@
+#ifndef FOLDERMODEL_H
+#define FOLDERMODEL_H
+
+#include <QAbstractListModel>
+#include <QIcon>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "DirectoryCache.h"
+
+// One row of the folder view
+struct FolderEntry {
+    QString name;
+    QString path;
+    bool isDir = false;
+    qint64 mtime = 0;       // ms since epoch, 0 until stat'd
+    quint8 content = DirectoryEntry::ContentUnknown;
+    QIcon thumbnail;        // GUI thread only
+    bool thumbnailLoaded = false;     // at the current tier
+    bool thumbnailFailed = false;     // undecodable: shows a placeholder, not requested again until the file changes
+    int thumbnailEdge = 0;            // longer side of the image behind `thumbnail`
+    bool checkable = false;
+    Qt::CheckState check = Qt::Unchecked;
+};
+
+// Folder view model for directories of any size.
+//
+// setDirectory() gets the sorted listing from DirectoryCache on a worker
+// thread (from memory when the folder is unchanged, otherwise names and types
+// without per-file stats) and hands it over in one go; rows are then exposed
+// in pages through canFetchMore/fetchMore, so the view lays out only what it
+// scrolls to. Two follow-up workers fill in missing file mtimes (in row order,
+// for the thumbnail cache keys and the listing cache; thumbnail jobs for rows
+// not reached yet stat their own file) and probe subfolders whose mtime changed;
+// folders that hold only non-image files are hidden, and shown again if
+// images appear. Once both are done the completed listing goes back to the
+// cache. Every worker result carries the listing generation and is dropped if
+// the directory changed meanwhile. Workers share the generation counter, not
+// the model, and post their results through a QPointer, so a model deleted
+// while they run is neither read nor called.
+class FolderModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        PathRole = Qt::UserRole,
+        ThumbnailLoadedRole = Qt::UserRole + 1,
+        ModifiedRole = Qt::UserRole + 2,        // source mtime (ms), 0 while unknown
+        IsDirRole = Qt::UserRole + 3
+    };
+
+    static constexpr int fetchBatch = 512;
+
+    explicit FolderModel(QObject* parent = nullptr);
+    ~FolderModel() override;
+
+    void setDirectory(const QString& path);
+    QString directory() const { return dirPath; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // Row of a path among the fetched rows, or -1
+    int rowOf(const QString& path) const;
+    QString pathAt(int row) const;
+
+    // Every image of the folder in view order, fetched or not (the viewer steps through these)
+    QStringList imagePaths() const;
+
+    // A stand-in (exact = false) from another tier never replaces a sharper thumbnail
+    void setThumbnail(const QString& path, const QImage& image, bool exact = true);
+
+    // The file could not be decoded: a placeholder, counted as loaded so the view stops asking
+    void setThumbnailFailed(const QString& path);
+
+    // Rows ask for thumbnails again (new folder contents or zoom); the old ones stay on screen meanwhile
+    void invalidateThumbnails();
+
+    // Files named in `matched` get a checked checkbox, all other files an unchecked one
+    void setMatchedFiles(const QSet<QString>& matched);
+
+signals:
+    // New rows or mtimes arrived: a good moment to ask for visible thumbnails
+    void entriesUpdated();
+
+private:
+    struct FolderProbe {
+        QString path;
+        quint8 content;
+        qint64 mtime;
+    };
+
+    void applyListing(quint64 generation, const DirectoryListing& listing, bool fromCache);
+    void applyMtimes(quint64 generation, const QVector<QPair<QString, qint64>>& mtimes);
+    void applyContent(quint64 generation, const QVector<FolderProbe>& probes);
+    void workerFinished(quint64 generation, qint64 dirMtimeAfter);
+    void hideRows(QList<int> rows);
+    void showFolder(const FolderEntry& folder);
+    void rebuildRowIndex();
+    DirectoryListing completedListing() const;
+
+    QString dirPath;
+    qint64 dirMtime = 0;
+    QVector<FolderEntry> entries;
+    QHash<QString, FolderEntry> hiddenFolders;   // only non-image files; still probed
+    int fetched = 0;
+    QHash<QString, int> rowByPath;
+    std::shared_ptr<std::atomic<quint64>> generation = std::make_shared<std::atomic<quint64>>(0);
+    int runningWorkers = 0;
+    bool listingChanged = false;     // worth writing back to DirectoryCache
+    bool listingStale = false;       // the folder changed while the workers ran: not cached
+
+    QIcon folderIcon;
+    QIcon placeholderIcon;
+    QIcon failedIcon;
+};
+
+#endif // FOLDERMODEL_H
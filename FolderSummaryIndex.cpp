@@ -0,0 +1,310 @@
+#include "FolderSummaryIndex.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QHash>
+#include <QSet>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+struct BestFace {
+    qint64 id = 0;
+    float quality = 0.0f;
+
+    void offer(qint64 faceId, float q) {
+        if (id == 0 || q > quality) {
+            id = faceId;
+            quality = q;
+        }
+    }
+};
+
+struct SummaryChange {
+    QString folder;
+    QString globalId;
+    int direct = 0;
+    int subtree = 0;
+    BestFace directBest;
+    BestFace subtreeBest;
+    QSet<qint64> removedIds;
+};
+
+using ChangeMap = QHash<QString, SummaryChange>;
+
+void accumulate(ChangeMap& changes, const FaceSummaryDelta& face, int sign) {
+    if (face.globalId.isEmpty() || face.clone) return;
+
+    const QStringList chain = FolderSummaryIndex::folderChain(face.imagePath);
+    for (int level = 0; level < chain.size(); ++level) {
+        SummaryChange& c = changes[chain[level] + QChar(0) + face.globalId];
+        c.folder = chain[level];
+        c.globalId = face.globalId;
+        c.subtree += sign;
+        if (level == 0) c.direct += sign;
+
+        if (sign > 0) {
+            c.subtreeBest.offer(face.faceId, face.quality);
+            if (level == 0) c.directBest.offer(face.faceId, face.quality);
+        } else {
+            c.removedIds.insert(face.faceId);
+        }
+    }
+}
+
+QString folderPrefix(const QString& folder) {
+    return folder == "/" ? folder : folder + "/";
+}
+
+// Best remaining face for (folder, identity); direct = only files directly in the folder
+bool pickBest(QSqlDatabase& db, const QString& folder, const QString& globalId, bool direct, QVariant& id, QVariant& quality) {
+    QString prefix = folderPrefix(folder);
+    QSqlQuery q(db);
+    q.prepare(QString(R"(
+        SELECT id, quality FROM face_embeddings
+        WHERE global_id = ? AND clone_of IS NULL AND substr(image_path, 1, ?) = ? %1
+        ORDER BY quality DESC LIMIT 1
+    )").arg(direct ? "AND instr(substr(image_path, ?), '/') = 0" : ""));
+    q.addBindValue(globalId);
+    q.addBindValue(prefix.length());
+    q.addBindValue(prefix);
+    if (direct) q.addBindValue(prefix.length() + 1);
+
+    if (!q.exec()) return false;
+    if (q.next()) {
+        id = q.value(0);
+        quality = q.value(1);
+    } else {
+        id = QVariant();
+        quality = QVariant();
+    }
+    return true;
+}
+
+bool writeChanges(QSqlDatabase& db, const ChangeMap& changes) {
+    QSqlQuery upsert(db);
+    upsert.prepare(R"(
+        INSERT INTO folder_person_summary (folder_path, global_id, direct_count, subtree_count,
+                                           direct_best_id, direct_best_quality, subtree_best_id, subtree_best_quality)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+        ON CONFLICT (folder_path, global_id) DO UPDATE SET
+            direct_count = direct_count + excluded.direct_count,
+            subtree_count = subtree_count + excluded.subtree_count,
+            direct_best_id = CASE WHEN excluded.direct_best_id IS NOT NULL
+                                   AND (direct_best_id IS NULL OR excluded.direct_best_quality > direct_best_quality)
+                             THEN excluded.direct_best_id ELSE direct_best_id END,
+            direct_best_quality = CASE WHEN excluded.direct_best_id IS NOT NULL
+                                        AND (direct_best_id IS NULL OR excluded.direct_best_quality > direct_best_quality)
+                                  THEN excluded.direct_best_quality ELSE direct_best_quality END,
+            subtree_best_id = CASE WHEN excluded.subtree_best_id IS NOT NULL
+                                    AND (subtree_best_id IS NULL OR excluded.subtree_best_quality > subtree_best_quality)
+                              THEN excluded.subtree_best_id ELSE subtree_best_id END,
+            subtree_best_quality = CASE WHEN excluded.subtree_best_id IS NOT NULL
+                                         AND (subtree_best_id IS NULL OR excluded.subtree_best_quality > subtree_best_quality)
+                                   THEN excluded.subtree_best_quality ELSE subtree_best_quality END
+    )");
+
+    QSqlQuery read(db);
+    read.prepare(R"(
+        SELECT direct_count, subtree_count, direct_best_id, subtree_best_id,
+               direct_best_quality, subtree_best_quality
+        FROM folder_person_summary WHERE folder_path = ? AND global_id = ?
+    )");
+    QSqlQuery drop(db);
+    drop.prepare("DELETE FROM folder_person_summary WHERE folder_path = ? AND global_id = ?");
+    QSqlQuery setBest(db);
+    setBest.prepare(R"(
+        UPDATE folder_person_summary
+        SET direct_best_id = ?, direct_best_quality = ?, subtree_best_id = ?, subtree_best_quality = ?
+        WHERE folder_path = ? AND global_id = ?
+    )");
+
+    auto bestValue = [](const BestFace& b, bool quality) {
+        if (b.id == 0) return QVariant();
+        return quality ? QVariant(b.quality) : QVariant(b.id);
+    };
+
+    for (const SummaryChange& c : changes) {
+        upsert.addBindValue(c.folder);
+        upsert.addBindValue(c.globalId);
+        upsert.addBindValue(c.direct);
+        upsert.addBindValue(c.subtree);
+        upsert.addBindValue(bestValue(c.directBest, false));
+        upsert.addBindValue(bestValue(c.directBest, true));
+        upsert.addBindValue(bestValue(c.subtreeBest, false));
+        upsert.addBindValue(bestValue(c.subtreeBest, true));
+        if (!upsert.exec()) {
+            qWarning() << "❌ Failed to update folder summary:" << c.folder << upsert.lastError().text();
+            return false;
+        }
+
+        if (c.removedIds.isEmpty()) continue;
+
+        // ✅ Removals: drop emptied rows, re-pick exemplars that were deleted
+        read.addBindValue(c.folder);
+        read.addBindValue(c.globalId);
+        if (!read.exec() || !read.next()) return false;
+        int directCount = read.value(0).toInt();
+        int subtreeCount = read.value(1).toInt();
+        QVariant directBest = read.value(2);
+        QVariant subtreeBest = read.value(3);
+        QVariant directQuality = read.value(4);
+        QVariant subtreeQuality = read.value(5);
+        read.finish();
+
+        if (subtreeCount <= 0) {
+            drop.addBindValue(c.folder);
+            drop.addBindValue(c.globalId);
+            if (!drop.exec()) return false;
+            continue;
+        }
+
+        bool directStale = directCount <= 0 ? !directBest.isNull() : c.removedIds.contains(directBest.toLongLong());
+        bool subtreeStale = c.removedIds.contains(subtreeBest.toLongLong());
+        if (!directStale && !subtreeStale) continue;
+
+        QVariant directId = directBest;
+        QVariant subtreeId = subtreeBest;
+        bool ok = true;
+        if (directStale) {
+            directId = directQuality = QVariant();
+            if (directCount > 0)
+                ok = pickBest(db, c.folder, c.globalId, true, directId, directQuality);
+        }
+        if (subtreeStale)
+            ok = ok && pickBest(db, c.folder, c.globalId, false, subtreeId, subtreeQuality);
+        if (!ok) return false;
+
+        setBest.addBindValue(directId);
+        setBest.addBindValue(directQuality);
+        setBest.addBindValue(subtreeId);
+        setBest.addBindValue(subtreeQuality);
+        setBest.addBindValue(c.folder);
+        setBest.addBindValue(c.globalId);
+        if (!setBest.exec()) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+QStringList FolderSummaryIndex::folderChain(const QString& imagePath) {
+    QStringList chain;
+    QString folder = imagePath;
+    int slash;
+    while ((slash = folder.lastIndexOf('/')) >= 0) {
+        folder = slash == 0 ? QString("/") : folder.left(slash);
+        chain << folder;
+        if (slash == 0) break;
+    }
+    return chain;
+}
+
+QString FolderSummaryIndex::folderKey(const QString& folderPath) {
+    QString key = QDir::cleanPath(folderPath);
+    if (key.length() > 1 && key.endsWith('/'))
+        key.chop(1);
+    return key;
+}
+
+QList<FaceSummaryDelta> FolderSummaryIndex::facesAt(QSqlDatabase& db, const QString& imagePath) {
+    QList<FaceSummaryDelta> faces;
+    QSqlQuery q(db);
+    q.prepare("SELECT id, global_id, quality, clone_of FROM face_embeddings WHERE image_path = ?");
+    q.addBindValue(imagePath);
+    if (q.exec()) {
+        while (q.next())
+            faces.append({ imagePath, q.value(1).toString(), q.value(0).toLongLong(), q.value(2).toFloat(),
+                           !q.value(3).isNull() });
+    }
+    return faces;
+}
+
+QList<FaceSummaryDelta> FolderSummaryIndex::facesUnder(QSqlDatabase& db, const QString& prefix) {
+    QList<FaceSummaryDelta> faces;
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    q.prepare("SELECT id, image_path, global_id, quality, clone_of FROM face_embeddings WHERE substr(image_path, 1, ?) = ?");
+    q.addBindValue(prefix.length());
+    q.addBindValue(prefix);
+    if (q.exec()) {
+        while (q.next())
+            faces.append({ q.value(1).toString(), q.value(2).toString(), q.value(0).toLongLong(), q.value(3).toFloat(),
+                           !q.value(4).isNull() });
+    }
+    return faces;
+}
+
+bool FolderSummaryIndex::promoteClones(QSqlDatabase& db, const QList<FaceSummaryDelta>& removed,
+                                       QList<FaceSummaryDelta>& promoted) {
+    QSqlQuery heir(db);
+    heir.prepare("SELECT id, image_path, global_id, quality FROM face_embeddings WHERE clone_of = ? ORDER BY id LIMIT 1");
+    QSqlQuery repoint(db);
+    repoint.prepare("UPDATE face_embeddings SET clone_of = CASE WHEN id = ? THEN NULL ELSE ? END WHERE clone_of = ?");
+
+    for (const FaceSummaryDelta& face : removed) {
+        if (face.clone) continue;
+
+        heir.addBindValue(face.faceId);
+        if (!heir.exec()) return false;
+        if (!heir.next()) continue;  // no copies of this face
+        FaceSummaryDelta next { heir.value(1).toString(), heir.value(2).toString(), heir.value(0).toLongLong(),
+                                heir.value(3).toFloat() };
+        heir.finish();
+
+        repoint.addBindValue(next.faceId);
+        repoint.addBindValue(next.faceId);
+        repoint.addBindValue(face.faceId);
+        if (!repoint.exec()) return false;
+        promoted.append(next);
+    }
+    return true;
+}
+
+bool FolderSummaryIndex::apply(QSqlDatabase& db, const QList<FaceSummaryDelta>& added,
+                               const QList<FaceSummaryDelta>& removed) {
+    if (added.isEmpty() && removed.isEmpty()) return true;
+
+    ChangeMap changes;
+    for (const FaceSummaryDelta& face : removed)
+        accumulate(changes, face, -1);
+    for (const FaceSummaryDelta& face : added)
+        accumulate(changes, face, +1);
+    return writeChanges(db, changes);
+}
+
+bool FolderSummaryIndex::rebuild(QSqlDatabase& db) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery q(db);
+    if (!q.exec("DELETE FROM folder_person_summary")) return false;
+
+    // Streamed in chunks so only one chunk's folder/identity pairs are in memory
+    QSqlQuery rows(db);
+    rows.setForwardOnly(true);
+    if (!rows.exec(R"(
+            SELECT id, image_path, global_id, quality FROM face_embeddings
+            WHERE global_id IS NOT NULL AND global_id <> '' AND clone_of IS NULL
+        )"))
+        return false;
+
+    ChangeMap changes;
+    int faceCount = 0;
+    while (rows.next()) {
+        accumulate(changes, { rows.value(1).toString(), rows.value(2).toString(),
+                              rows.value(0).toLongLong(), rows.value(3).toFloat() }, +1);
+        if (++faceCount % 50000 == 0) {
+            if (!writeChanges(db, changes)) return false;
+            changes.clear();
+        }
+    }
+    rows.finish();
+
+    if (!writeChanges(db, changes)) return false;
+    qDebug() << "📊 Rebuilt folder summaries from" << faceCount << "face(s) in" << timer.elapsed() << "ms";
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef FOLDERSUMMARYINDEX_H
+#define FOLDERSUMMARYINDEX_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// A face row as seen by folder_person_summary
+struct FaceSummaryDelta {
+    QString imagePath;
+    QString globalId;
+    qint64 faceId = 0;
+    float quality = 0.0f;
+    bool clone = false;         // copy of another file's face (face_embeddings.clone_of), never counted
+};
+
+// Maintains folder_person_summary: for every folder and identity, how many
+// faces sit directly in the folder, how many anywhere below it, and the best
+// (highest quality) exemplar of each. A face counts towards its folder and
+// every ancestor, so any folder's face list is a single indexed lookup.
+// Rows copied from an identical file (clone_of set) are not counted: each
+// photo's faces count once, through the canonical rows.
+// All calls run inside the caller's write transaction.
+class FolderSummaryIndex {
+public:
+    // Folders a face in imagePath counts towards, nearest first ("/a/b/x.jpg" -> "/a/b", "/a", "/")
+    static QStringList folderChain(const QString& imagePath);
+
+    // Canonical folder key ("C:/" -> "C:", "/photos/" -> "/photos")
+    static QString folderKey(const QString& folderPath);
+
+    // Face rows of one image, or of every image below a folder prefix ("/a/b/")
+    static QList<FaceSummaryDelta> facesAt(QSqlDatabase& db, const QString& imagePath);
+    static QList<FaceSummaryDelta> facesUnder(QSqlDatabase& db, const QString& folderPrefix);
+
+    // Call before deleting `removed`: one copy of each deleted canonical face takes its place
+    // (clone_of cleared, the other copies re-pointed) and is returned for counting
+    static bool promoteClones(QSqlDatabase& db, const QList<FaceSummaryDelta>& removed, QList<FaceSummaryDelta>& promoted);
+
+    // Call after the rows changed: best exemplars are re-picked from face_embeddings
+    static bool apply(QSqlDatabase& db, const QList<FaceSummaryDelta>& added, const QList<FaceSummaryDelta>& removed);
+
+    // Recomputes the whole table from face_embeddings
+    static bool rebuild(QSqlDatabase& db);
+};
+
+#endif // FOLDERSUMMARYINDEX_H
@@ -0,0 +1,124 @@
+#include "IdentityIndex.h"
+#include "embeddingUtils.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QByteArray>
+#include <QDebug>
+#include <cstring>
+
+static QByteArray toBlob(const std::vector<float>& embedding) {
+    QByteArray blob;
+    blob.resize(static_cast<int>(embedding.size() * sizeof(float)));
+    std::memcpy(blob.data(), embedding.data(), blob.size());
+    return blob;
+}
+
+static std::vector<float> fromBlob(const QByteArray& blob) {
+    std::vector<float> embedding(blob.size() / sizeof(float));
+    std::memcpy(embedding.data(), blob.constData(), embedding.size() * sizeof(float));
+    return embedding;
+}
+
+bool IdentityIndex::load(QSqlDatabase& db) {
+    centroids.clear();
+
+    // Rows created by older versions have no global_id; their rowid is the id they were handed out as
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if (!q.exec(R"(
+            SELECT rowid, COALESCE(global_id, CAST(rowid AS TEXT)), avg_embedding, COALESCE(count, 1)
+            FROM global_faces
+        )")) {
+        qWarning() << "❌ Failed to load identities:" << q.lastError().text();
+        return false;
+    }
+
+    while (q.next()) {
+        Centroid c;
+        c.rowId = q.value(0).toLongLong();
+        c.id = q.value(1).toString();
+        c.embedding = fromBlob(q.value(2).toByteArray());
+        c.count = qMax<qint64>(1, q.value(3).toLongLong());
+        centroids.append(c);
+    }
+
+    loaded = true;
+    qDebug() << "👥 Loaded" << centroids.size() << "identity centroid(s)";
+    return true;
+}
+
+QString IdentityIndex::assign(QSqlDatabase& db, const std::vector<float>& embedding) {
+    if (embedding.empty()) return QString();
+    if (!loaded && !load(db)) return QString();
+
+    int best = -1;
+    float bestDist = matchDistance;
+    for (int i = 0; i < centroids.size(); ++i) {
+        if (centroids[i].embedding.size() != embedding.size()) continue;
+        float dist = l2Distance(embedding, centroids[i].embedding);
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = i;
+        }
+    }
+
+    if (best >= 0) {
+        Centroid& c = centroids[best];
+        for (size_t k = 0; k < embedding.size(); ++k)
+            c.embedding[k] += (embedding[k] - c.embedding[k]) / (c.count + 1);
+        ++c.count;
+        c.dirty = true;
+        return c.id;
+    }
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO global_faces (avg_embedding, count) VALUES (?, 1)");
+    insert.addBindValue(toBlob(embedding));
+    if (!insert.exec()) {
+        qWarning() << "❌ Failed to insert global face ID:" << insert.lastError().text();
+        return QString();
+    }
+
+    Centroid c;
+    c.rowId = insert.lastInsertId().toLongLong();
+    c.id = QString::number(c.rowId);
+    c.embedding = embedding;
+
+    QSqlQuery name(db);
+    name.prepare("UPDATE global_faces SET global_id = ? WHERE rowid = ?");
+    name.addBindValue(c.id);
+    name.addBindValue(c.rowId);
+    if (!name.exec()) {
+        qWarning() << "❌ Failed to name global face ID:" << name.lastError().text();
+        return QString();
+    }
+
+    centroids.append(c);
+    return c.id;
+}
+
+bool IdentityIndex::flush(QSqlDatabase& db) {
+    QSqlQuery update(db);
+    update.prepare("UPDATE global_faces SET global_id = ?, avg_embedding = ?, count = ? WHERE rowid = ?");
+
+    for (Centroid& c : centroids) {
+        if (!c.dirty) continue;
+        update.addBindValue(c.id);
+        update.addBindValue(toBlob(c.embedding));
+        update.addBindValue(c.count);
+        update.addBindValue(c.rowId);
+        if (!update.exec()) {
+            qWarning() << "❌ Failed to update identity" << c.id << update.lastError().text();
+            return false;
+        }
+        c.dirty = false;
+    }
+    return true;
+}
+
+void IdentityIndex::invalidate() {
+    centroids.clear();
+    loaded = false;
+}
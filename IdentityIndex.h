@@ -0,0 +1,41 @@
+#ifndef IDENTITYINDEX_H
+#define IDENTITYINDEX_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QList>
+#include <vector>
+
+// In-memory copy of global_faces used to give every new face a global_id
+// without re-reading all centroids per face. Not thread-safe on its own:
+// every call must happen while holding the writer lease, on its connection.
+class IdentityIndex {
+public:
+    static constexpr float matchDistance = 0.5f;
+
+    // Nearest centroid within matchDistance (its running mean absorbs the face),
+    // otherwise a new identity row. Empty embedding -> empty id.
+    QString assign(QSqlDatabase& db, const std::vector<float>& embedding);
+
+    // Persists centroids changed by assign(); call before committing
+    bool flush(QSqlDatabase& db);
+
+    // Forget the cache, e.g. after a rollback or a bulk change to global_faces
+    void invalidate();
+
+private:
+    struct Centroid {
+        qint64 rowId = 0;
+        QString id;
+        std::vector<float> embedding;
+        qint64 count = 1;
+        bool dirty = false;
+    };
+
+    bool load(QSqlDatabase& db);
+
+    QList<Centroid> centroids;
+    bool loaded = false;
+};
+
+#endif // IDENTITYINDEX_H
@@ -0,0 +1,70 @@
+#include "ImageFingerprint.h"
+#include <QFile>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+constexpr qint64 SAMPLE_BLOCK = 64 * 1024;
+
+QString quickContentHash(const QString& path, qint64 fileSize) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "❌ Cannot open for fingerprint:" << path;
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    // Head, middle and tail blocks; small files are hashed in full
+    if (fileSize <= 3 * SAMPLE_BLOCK) {
+        hash.addData(file.readAll());
+    } else {
+        const qint64 offsets[] = { 0, (fileSize - SAMPLE_BLOCK) / 2, fileSize - SAMPLE_BLOCK };
+        for (qint64 offset : offsets) {
+            file.seek(offset);
+            hash.addData(file.read(SAMPLE_BLOCK));
+        }
+    }
+
+    return QString::number(fileSize) + ":" + QString::fromLatin1(hash.result().toHex());
+}
+
+QString fullContentHash(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file))
+        return QString();
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString fileIdentity(const QString& path) {
+#ifdef Q_OS_WIN
+    HANDLE h = CreateFileW(reinterpret_cast<LPCWSTR>(path.utf16()), 0,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return QString();
+
+    BY_HANDLE_FILE_INFORMATION fi;
+    bool ok = GetFileInformationByHandle(h, &fi);
+    CloseHandle(h);
+    if (!ok)
+        return QString();
+
+    quint64 index = (quint64(fi.nFileIndexHigh) << 32) | fi.nFileIndexLow;
+    return QString("%1:%2").arg(fi.dwVolumeSerialNumber).arg(index);
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return QString();
+    return QString("%1:%2").arg(quint64(st.st_dev)).arg(quint64(st.st_ino));
+#endif
+}
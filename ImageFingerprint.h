@@ -0,0 +1,17 @@
+#ifndef IMAGEFINGERPRINT_H
+#define IMAGEFINGERPRINT_H
+
+#include <QString>
+
+// Cheap content fingerprint: file size plus hashes of a few sampled blocks.
+// Identical files always match; a match is confirmed with fullContentHash().
+QString quickContentHash(const QString& path, qint64 fileSize);
+
+// Hash of the whole file, used only to settle quick-hash collisions
+QString fullContentHash(const QString& path);
+
+// Stable file identity (device + inode, or volume + file index on Windows).
+// Survives renames and moves within a volume; empty if unavailable.
+QString fileIdentity(const QString& path);
+
+#endif // IMAGEFINGERPRINT_H
@@ -0,0 +1,198 @@
+#include "ImageViewer.h"
+#include "ThumbnailStore.h"
+#include "ThumbnailCache.h"
+
+#include <QVBoxLayout>
+#include <QKeyEvent>
+#include <QScreen>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+ImageViewer::ImageViewer(const QStringList& imagePaths, int index, QWidget* parent)
+    : QDialog(parent), paths(imagePaths) {
+    // Decode for the whole screen, so maximizing needs no second decode
+    QScreen* screen = parent ? parent->screen() : this->screen();
+    const QRect available = screen->availableGeometry();
+    decodeBox = available.size() * screen->devicePixelRatio();
+    resize(available.size() * 4 / 5);
+
+    label = new QLabel(this);
+    label->setAlignment(Qt::AlignCenter);
+    label->setMinimumSize(1, 1);  // let the dialog shrink below the pixmap
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(label);
+    setLayout(layout);
+
+    // Current image first, one neighbour alongside; the GUI thread only scales for display
+    pool.setMaxThreadCount(2);
+    pool.setObjectName("ImageViewer");
+    screenImages.setMaxCost(cacheBudgetKb);
+
+    // Fast scaling while the window is dragged, one smooth scale once it stops
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(150);
+    connect(&settleTimer, &QTimer::timeout, this, [this]() { updatePixmap(Qt::SmoothTransformation); });
+
+    showIndex(index);
+}
+
+ImageViewer::~ImageViewer() {
+    current = -1;       // queued neighbour decodes skip the work
+    pool.clear();
+    pool.waitForDone();
+}
+
+QImage ImageViewer::thumbnailFor(const QString& path) {
+    // Largest tier first: memory, then the folder's pack (a small JPEG read, no source decode)
+    QFileInfo info(path);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+    const QList<int>& tiers = ThumbnailStore::tiers();
+    for (int i = tiers.size() - 1; i >= 0; --i) {
+        QImage image = ThumbnailCache::instance().find(path, mtime, tiers[i]);
+        if (!image.isNull()) return image;
+    }
+    for (int i = tiers.size() - 1; i >= 0; --i) {
+        QImage image = ThumbnailStore::instance().find(info, tiers[i]);
+        if (!image.isNull()) return image;
+    }
+    return QImage();
+}
+
+void ImageViewer::showIndex(int index) {
+    if (index < 0 || index >= paths.size()) return;
+    current = index;
+
+    const QString& path = paths[index];
+    setWindowTitle(QString("%1 (%2/%3)").arg(QFileInfo(path).fileName()).arg(index + 1).arg(paths.size()));
+
+    // ✅ Already decoded (preloaded neighbour or seen before): final quality right away
+    if (const QImage* ready = screenImages.object(path)) {
+        showImage(path, *ready, true);
+    } else {
+        showImage(path, QImage(), false);
+        requestThumbnail(path);     // blurry for a moment, ahead of the full decode
+        request(index, 1);
+    }
+
+    // Neighbours behind the current image
+    request(index + 1, 0);
+    request(index - 1, 0);
+}
+
+void ImageViewer::requestThumbnail(const QString& path) {
+    // Stat and pack read stay off the GUI thread too; ahead of every decode in the queue
+    pool.start([this, path]() {
+        QImage image;
+        if (paths.value(current) == path)
+            image = thumbnailFor(path);
+        if (image.isNull()) return;
+        QMetaObject::invokeMethod(this, [this, path, image]() {
+            // Only as a stand-in: the decode may have won the race, or the user paged on
+            if (shownPath == path && !shownFinal)
+                showImage(path, image, false);
+        }, Qt::QueuedConnection);
+    }, 2);
+}
+
+void ImageViewer::request(int index, int priority) {
+    if (index < 0 || index >= paths.size()) return;
+
+    const QString path = paths[index];
+    if (inFlight.contains(path) || screenImages.contains(path)) return;
+    inFlight.insert(path);
+
+    const QSize box = decodeBox;
+    pool.start([this, path, index, box]() {
+        // Paged more than one image away before this started: not worth the decode any more
+        QImage image;
+        qint64 ms = 0;
+        if (qAbs(index - current) <= 1) {
+            QElapsedTimer timer;
+            timer.start();
+            QString error;
+            image = ThumbnailStore::decodeScaled(path, box, &error);
+            ms = timer.elapsed();
+            if (image.isNull())
+                qWarning() << "❌ Failed to load image:" << path << "| Error:" << error;
+        }
+        QMetaObject::invokeMethod(this, [this, path, image, ms]() {
+            decoded(path, image, ms);
+        }, Qt::QueuedConnection);
+    }, priority);
+}
+
+void ImageViewer::decoded(const QString& path, const QImage& image, qint64 ms) {
+    inFlight.remove(path);
+    if (image.isNull()) {
+        if (shownPath == path && shown.isNull()) {
+            shownFinal = true;
+            updatePixmap(Qt::SmoothTransformation);   // no stand-in either: say so
+        }
+        return;
+    }
+
+    qDebug() << "🖼️ Decoded" << QFileInfo(path).fileName() << image.size() << "in" << ms << "ms";
+    const int costKb = qMax(1, static_cast<int>(image.sizeInBytes() / 1024));
+    screenImages.insert(path, new QImage(image), costKb);
+
+    if (shownPath == path)
+        showImage(path, image, true);
+}
+
+void ImageViewer::showImage(const QString& path, const QImage& image, bool final) {
+    shownPath = path;
+    shown = image;
+    shownFinal = final;
+    scaled = QPixmap();
+    updatePixmap(Qt::SmoothTransformation);
+}
+
+void ImageViewer::updatePixmap(Qt::TransformationMode mode) {
+    if (shown.isNull()) {
+        label->setText(shownFinal ? "⚠️ Could not load image" : QString());
+        return;
+    }
+
+    // Only the one on-screen image is scaled here, and only when its size or quality changes
+    const QSize target = label->size() * devicePixelRatioF();
+    if (!scaled.isNull() && scaledFor == target && (scaledSmooth || mode == Qt::FastTransformation))
+        return;
+
+    scaled = QPixmap::fromImage(shown.scaled(target, Qt::KeepAspectRatio, mode));
+    scaled.setDevicePixelRatio(devicePixelRatioF());
+    scaledFor = target;
+    scaledSmooth = mode == Qt::SmoothTransformation;
+    label->setPixmap(scaled);
+}
+
+void ImageViewer::resizeEvent(QResizeEvent* event) {
+    QDialog::resizeEvent(event);
+    updatePixmap(Qt::FastTransformation);
+    settleTimer.start();    // restart: a drag collapses into one smooth scale at the end
+}
+
+void ImageViewer::keyPressEvent(QKeyEvent* event) {
+    switch (event->key()) {
+    case Qt::Key_Right:
+    case Qt::Key_PageDown:
+    case Qt::Key_Space:
+        showIndex(current + 1);
+        break;
+    case Qt::Key_Left:
+    case Qt::Key_PageUp:
+    case Qt::Key_Backspace:
+        showIndex(current - 1);
+        break;
+    case Qt::Key_Home:
+        showIndex(0);
+        break;
+    case Qt::Key_End:
+        showIndex(paths.size() - 1);
+        break;
+    default:
+        QDialog::keyPressEvent(event);
+    }
+}
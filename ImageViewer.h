@@ -0,0 +1,61 @@
+#ifndef IMAGEVIEWER_H
+#define IMAGEVIEWER_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QThreadPool>
+#include <QTimer>
+#include <QCache>
+#include <QImage>
+#include <QSet>
+#include <QStringList>
+#include <atomic>
+
+// Photo viewer for a folder's images that never decodes on the GUI thread.
+//
+// Opening (or stepping to) an image shows its largest stored thumbnail as
+// soon as a worker has read it, then swaps in a decode at screen resolution
+// (DCT-scaled for JPEG, so a 50 MP original is never built at full size).
+// The previous and next images are decoded behind the current one, and
+// screen-sized images stay in a byte-bounded cache while the viewer is open,
+// so paging back and forth is instant. The scaled pixmap is reused until the
+// window size changes. Left/Right (or PageUp/PageDown, Home/End) step.
+class ImageViewer : public QDialog {
+    Q_OBJECT
+
+public:
+    ImageViewer(const QStringList& paths, int index, QWidget* parent = nullptr);
+    ~ImageViewer();
+
+protected:
+    void keyPressEvent(QKeyEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    void showIndex(int index);
+    void requestThumbnail(const QString& path);
+    void request(int index, int priority);
+    void decoded(const QString& path, const QImage& image, qint64 ms);
+    void showImage(const QString& path, const QImage& image, bool final);
+    void updatePixmap(Qt::TransformationMode mode);
+    static QImage thumbnailFor(const QString& path);
+
+    static constexpr int cacheBudgetKb = 192 * 1024;   // about five 4K screens
+
+    QStringList paths;
+    std::atomic<int> current { -1 };    // read by decode jobs to skip images paged past
+    QSize decodeBox;                    // screen size in device pixels
+    QLabel* label = nullptr;
+    QString shownPath;                  // image the window is showing (or waiting for)
+    QImage shown;                       // null until a stand-in or the decode arrives
+    bool shownFinal = false;            // screen decode (or its failure), not a stand-in
+    QPixmap scaled;                     // `shown` at the label's size, reused until that changes
+    QSize scaledFor;
+    bool scaledSmooth = false;
+    QTimer settleTimer;                 // smooth rescale once resizing stops
+    QThreadPool pool;
+    QSet<QString> inFlight;
+    QCache<QString, QImage> screenImages;   // cost in KB
+};
+
+#endif // IMAGEVIEWER_H
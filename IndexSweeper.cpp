@@ -0,0 +1,113 @@
+#include "IndexSweeper.h"
+#include "FaceDatabaseManager.h"
+#include "EmbeddingStore.h"
+#include "ScanPipeline.h"
+#include <QtConcurrent/QtConcurrentRun>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QDebug>
+
+IndexSweeper::IndexSweeper(QObject* parent) : QObject(parent) {
+    qRegisterMetaType<SweepReport>("SweepReport");
+}
+
+IndexSweeper::~IndexSweeper() {
+    stop();
+    worker.waitForFinished();  // returns at the next abort check
+}
+
+void IndexSweeper::start() {
+    if (running.exchange(true)) return;
+    abortFlag = false;
+
+    worker = QtConcurrent::run([this]() {
+        SweepReport report = sweep();
+        emit finished(report);
+        running = false;
+    });
+}
+
+void IndexSweeper::stop() {
+    abortFlag = true;
+}
+
+SweepReport IndexSweeper::sweep() {
+    SweepReport report;
+    FaceDatabaseManager& dbm = FaceDatabaseManager::instance();
+    QString cursor;
+
+    QStringList roots;
+    for (const QString& root : dbm.libraryRoots().keys())
+        roots << QDir::cleanPath(root);
+
+    qDebug() << "🧹 Index sweep started";
+
+    while (!abortFlag) {
+        QStringList paths = dbm.indexedPathsAfter(cursor, batchSize);
+        if (paths.isEmpty()) break;
+        cursor = paths.last();
+
+        QStringList missing;
+        QHash<QString, bool> rootAvailable;     // checked per batch: a drive may go away mid-sweep
+        for (const QString& path : paths) {
+            if (QFileInfo::exists(path)) continue;
+
+            const QString root = ScanPipeline::libraryRootOf(path, roots);
+            bool purge;
+            if (root.isEmpty()) {
+                // No root to vouch for the volume: only a file gone from a folder that is still there
+                purge = QFileInfo(QFileInfo(path).absolutePath()).isDir();
+            } else {
+                auto known = rootAvailable.constFind(root);
+                if (known == rootAvailable.constEnd())
+                    known = rootAvailable.insert(root, ScanPipeline::isLibraryRootAvailable(root));
+                purge = known.value();
+                if (!purge && !report.unavailableRoots.contains(root)) {
+                    qWarning() << "⚠️ Library root unavailable, its files are kept:" << root;
+                    report.unavailableRoots << root;
+                }
+            }
+
+            if (purge)
+                missing << path;
+            else
+                ++report.pathsSkipped;
+        }
+        report.pathsChecked += paths.size();
+
+        if (!missing.isEmpty()) {
+            report.facesPurged += dbm.removePaths(missing);
+            report.pathsPurged += missing.size();
+        }
+
+        // ✅ Rate limit: leave the disk and the writer lock to foreground work
+        QThread::msleep(pauseMs);
+    }
+
+    if (abortFlag) {
+        qDebug() << "⏹️ Index sweep aborted after" << report.pathsChecked << "path(s)";
+        return report;
+    }
+
+    if (report.pathsPurged > 0)
+        report.identitiesPurged = dbm.purgeOrphanIdentities();
+
+    // Deleted rows linger in the append-only vector file until it is rewritten
+    if (!abortFlag)
+        EmbeddingStore::instance().compactIfSparse();
+
+    // ✅ A VACUUM cannot be interrupted once started: never begin one after stop()
+    qint64 reclaimable = abortFlag ? 0 : dbm.reclaimableBytes();
+    if (!abortFlag && reclaimable >= vacuumThresholdBytes) {
+        report.vacuumed = dbm.compact();
+        if (report.vacuumed)
+            report.bytesReclaimed = qMax<qint64>(0, reclaimable - dbm.reclaimableBytes());
+    }
+
+    qDebug() << "🧹 Index sweep done: checked" << report.pathsChecked
+             << "purged paths" << report.pathsPurged << "faces" << report.facesPurged
+             << "skipped" << report.pathsSkipped << "(" << report.unavailableRoots.size() << "root(s) unavailable )"
+             << "identities" << report.identitiesPurged << "reclaimed bytes" << report.bytesReclaimed;
+    return report;
+}
@@ -0,0 +1,60 @@
+#ifndef INDEXSWEEPER_H
+#define INDEXSWEEPER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMetaType>
+#include <QFuture>
+#include <atomic>
+
+struct SweepReport {
+    int pathsChecked = 0;
+    int pathsPurged = 0;        // files that no longer exist
+    int pathsSkipped = 0;       // missing, but their library root or volume is gone too
+    QStringList unavailableRoots;
+    int facesPurged = 0;
+    int identitiesPurged = 0;   // global_faces rows no face refers to anymore
+    qint64 bytesReclaimed = 0;
+    bool vacuumed = false;
+};
+Q_DECLARE_METATYPE(SweepReport)
+
+// Background garbage collector for the face index: walks indexed paths in
+// small batches, purges rows for files that are gone and compacts the DB
+// when enough space is free. Rate limited so it never competes with scans.
+// Files under a library root that is not available (unplugged drive,
+// unmounted share) are left alone and the root is reported instead.
+// stop() is honoured between batches and before every maintenance step, so
+// the destructor waits for at most one batch (or a compaction already running).
+class IndexSweeper : public QObject {
+    Q_OBJECT
+public:
+    explicit IndexSweeper(QObject* parent = nullptr);
+    ~IndexSweeper() override;
+
+    void setBatchSize(int paths) { batchSize = paths; }
+    void setPauseBetweenBatches(int ms) { pauseMs = ms; }
+    void setVacuumThreshold(qint64 bytes) { vacuumThresholdBytes = bytes; }
+
+    bool isRunning() const { return running; }
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void finished(const SweepReport& report);
+
+private:
+    SweepReport sweep();
+
+    int batchSize = 200;
+    int pauseMs = 50;
+    qint64 vacuumThresholdBytes = 16LL * 1024 * 1024;
+    std::atomic_bool running = false;
+    std::atomic_bool abortFlag = false;
+    QFuture<void> worker;
+};
+
+#endif // INDEXSWEEPER_H
@@ -0,0 +1,285 @@
+#include "LibraryWatcher.h"
+#include "ScanPipeline.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+#include <utility>
+
+LibraryWatcher::LibraryWatcher(QObject* parent) : QObject(parent) {
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(1500);
+    reconcileTimer.setInterval(10 * 60 * 1000);
+    resumeTimer.setInterval(30 * 1000);
+
+    // ✅ Tree walks and diffs run here, never on the GUI thread; one thread keeps them in order
+    pool.setMaxThreadCount(1);
+    pool.setObjectName("LibraryWatcher");
+
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &LibraryWatcher::onDirectoryChanged);
+    connect(&debounceTimer, &QTimer::timeout, this, &LibraryWatcher::processPendingDirectories);
+    connect(&reconcileTimer, &QTimer::timeout, this, &LibraryWatcher::reconcile);
+    connect(&resumeTimer, &QTimer::timeout, this, &LibraryWatcher::checkSuspendedRoots);
+}
+
+LibraryWatcher::~LibraryWatcher() {
+    pool.clear();
+    pool.waitForDone();
+}
+
+void LibraryWatcher::addRoot(const QString& rootPath, bool recursive) {
+    QString root = QDir::cleanPath(rootPath);
+    if (root.isEmpty()) return;
+
+    // Already covered by itself or by a recursive parent
+    auto known = rootModes.constFind(root);
+    if (known != rootModes.constEnd() && (known.value() || !recursive)) return;
+    for (auto it = rootModes.constBegin(); it != rootModes.constEnd(); ++it) {
+        if (it.value() && root.startsWith(it.key() + "/")) return;
+    }
+
+    // A recursive root absorbs shallow roots below it
+    if (recursive) {
+        for (auto it = rootModes.begin(); it != rootModes.end();) {
+            if (it.key().startsWith(root + "/"))
+                it = rootModes.erase(it);
+            else
+                ++it;
+        }
+    }
+    rootModes.insert(root, recursive);
+
+    runInBackground([this, root, recursive](TreeUpdate& update) {
+        watchTree(root, recursive, nullptr, update);
+    }, "👀 Watching library root");
+
+    if (!reconcileTimer.isActive())
+        reconcileTimer.start();
+}
+
+void LibraryWatcher::runInBackground(const std::function<void(TreeUpdate&)>& work, const char* label) {
+    pool.start([this, work, label]() {
+        TreeUpdate update;
+        work(update);
+        QMetaObject::invokeMethod(this, [this, update, label]() {
+            apply(update, label);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LibraryWatcher::apply(const TreeUpdate& update, const char* label) {
+    for (const QString& root : update.suspended) {
+        qWarning() << "🔌 Library root offline, suspended until it is back:" << root;
+        offlineRoots.insert(root);
+    }
+    for (const QString& root : update.resumed) {
+        qDebug() << "🔌 Library root back:" << root;
+        offlineRoots.remove(root);
+    }
+    if (offlineRoots.isEmpty())
+        resumeTimer.stop();
+    else if (!resumeTimer.isActive())
+        resumeTimer.start();
+
+    if (!update.unwatch.isEmpty())
+        watcher.removePaths(update.unwatch);
+
+    // Beyond the watch limit the snapshots are still kept; reconcile() covers those folders
+    if (!update.watch.isEmpty()) {
+        const QStringList watched = watcher.directories();
+        const QSet<QString> already(watched.begin(), watched.end());
+        QStringList add;
+        for (const QString& dir : update.watch) {
+            if (!already.contains(dir))     // a resumed root may have kept some of its watches
+                add << dir;
+        }
+        int room = maxWatchedFolders - static_cast<int>(watched.size());
+        if (room > 0 && !add.isEmpty())
+            watcher.addPaths(add.mid(0, room));
+    }
+
+    if (!update.changed.isEmpty() || !update.removed.isEmpty()) {
+        qDebug() << label << ":" << update.changed.size() << "changed," << update.removed.size() << "removed";
+        emit filesChanged(update.changed, update.removed);
+    } else if (!update.watch.isEmpty()) {
+        qDebug() << label << "(" << watcher.directories().size() << "folders )";
+    }
+}
+
+bool LibraryWatcher::isRecursive(const QString& dirPath, const RootModes& roots) {
+    for (auto it = roots.constBegin(); it != roots.constEnd(); ++it) {
+        if (it.value() && (dirPath == it.key() || dirPath.startsWith(it.key() + "/")))
+            return true;
+    }
+    return false;
+}
+
+bool LibraryWatcher::isUnderAny(const QString& dirPath, const QSet<QString>& roots) {
+    for (const QString& root : roots) {
+        if (dirPath == root || dirPath.startsWith(root + "/"))
+            return true;
+    }
+    return false;
+}
+
+QSet<QString> LibraryWatcher::refreshAvailability(const RootModes& roots, TreeUpdate& update) {
+    QSet<QString> offline;
+    for (auto it = roots.constBegin(); it != roots.constEnd(); ++it) {
+        const QString& root = it.key();
+        if (!ScanPipeline::isLibraryRootAvailable(root)) {
+            offline.insert(root);
+            if (!suspended.contains(root)) {
+                suspended.insert(root);
+                update.suspended << root;
+            }
+        } else if (suspended.remove(root)) {
+            update.resumed << root;
+        }
+    }
+
+    // ✅ Back again: its watches went with the volume, and anything may have changed meanwhile
+    for (const QString& root : std::as_const(update.resumed)) {
+        const QStringList known = snapshots.keys();
+        for (const QString& dir : known) {
+            if ((dir != root && !dir.startsWith(root + "/")) || !snapshots.contains(dir)) continue;
+            if (QFileInfo(dir).isDir())
+                update.watch << dir;
+            diffDirectory(dir, roots, offline, update);
+        }
+    }
+    return offline;
+}
+
+LibraryWatcher::Snapshot LibraryWatcher::snapshotOf(const QString& dirPath, QStringList* subdirs) {
+    Snapshot snap;
+    QDir dir(dirPath);
+    const QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QFileInfo& entry : entries) {
+        if (entry.isDir()) {
+            if (subdirs) *subdirs << entry.absoluteFilePath();
+        } else if (ScanPipeline::isImageFile(entry.fileName())) {
+            snap.insert(entry.fileName(), { entry.size(), entry.lastModified().toSecsSinceEpoch() });
+        }
+    }
+    return snap;
+}
+
+void LibraryWatcher::watchTree(const QString& dirPath, bool recursive, QStringList* createdFiles, TreeUpdate& update) {
+    QStringList stack { dirPath };
+    while (!stack.isEmpty()) {
+        QString current = stack.takeLast();
+        QStringList subdirs;
+        Snapshot snap = snapshotOf(current, recursive ? &subdirs : nullptr);
+        const bool known = snapshots.contains(current);
+        snapshots.insert(current, snap);
+
+        if (createdFiles) {
+            for (auto it = snap.constBegin(); it != snap.constEnd(); ++it)
+                *createdFiles << current + "/" + it.key();
+        }
+
+        if (!known)
+            update.watch << current;
+
+        for (const QString& sub : subdirs)
+            stack << QDir::cleanPath(sub);
+    }
+}
+
+void LibraryWatcher::forgetTree(const QString& dirPath, TreeUpdate& update) {
+    QString prefix = dirPath + "/";
+    for (auto it = snapshots.begin(); it != snapshots.end();) {
+        if (it.key() == dirPath || it.key().startsWith(prefix)) {
+            for (auto f = it.value().constBegin(); f != it.value().constEnd(); ++f)
+                update.removed << it.key() + "/" + f.key();
+            update.unwatch << it.key();
+            it = snapshots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LibraryWatcher::onDirectoryChanged(const QString& path) {
+    pendingDirs.insert(QDir::cleanPath(path));
+    debounceTimer.start();  // restart: bursts (imports, copies) collapse into one pass
+}
+
+void LibraryWatcher::diffDirectory(const QString& dirPath, const RootModes& roots, const QSet<QString>& offline,
+                                   TreeUpdate& update) {
+    // Suspended root: its files are out of reach, not deleted; the snapshot waits for it
+    if (isUnderAny(dirPath, offline))
+        return;
+
+    if (!QFileInfo(dirPath).isDir()) {
+        forgetTree(dirPath, update);
+        return;
+    }
+
+    const bool recursive = isRecursive(dirPath, roots);
+    QStringList subdirs;
+    Snapshot now = snapshotOf(dirPath, recursive ? &subdirs : nullptr);
+    Snapshot before = snapshots.value(dirPath);
+
+    for (auto it = now.constBegin(); it != now.constEnd(); ++it) {
+        auto old = before.constFind(it.key());
+        if (old == before.constEnd() || old.value() != it.value())
+            update.changed << dirPath + "/" + it.key();
+    }
+    for (auto it = before.constBegin(); it != before.constEnd(); ++it) {
+        if (!now.contains(it.key()))
+            update.removed << dirPath + "/" + it.key();
+    }
+    snapshots.insert(dirPath, now);
+    if (!recursive) return;
+
+    // New subfolders (created or moved in) bring all their images with them
+    for (const QString& sub : subdirs) {
+        QString clean = QDir::cleanPath(sub);
+        if (!snapshots.contains(clean))
+            watchTree(clean, true, &update.changed, update);
+    }
+
+    // Subfolders that vanished (deleted or moved away)
+    QString prefix = dirPath + "/";
+    QStringList gone;
+    for (auto it = snapshots.constBegin(); it != snapshots.constEnd(); ++it) {
+        const QString& known = it.key();
+        if (known.startsWith(prefix) && !known.mid(prefix.length()).contains('/') && !QFileInfo(known).isDir()
+            && !isUnderAny(known, offline))   // a nested root's mount point, not a deleted folder
+            gone << known;
+    }
+    for (const QString& g : gone)
+        forgetTree(g, update);
+}
+
+void LibraryWatcher::processPendingDirectories() {
+    const QSet<QString> dirs = std::exchange(pendingDirs, {});
+    const RootModes roots = rootModes;
+    runInBackground([this, dirs, roots](TreeUpdate& update) {
+        const QSet<QString> offline = refreshAvailability(roots, update);
+        for (const QString& dir : dirs)
+            diffDirectory(dir, roots, offline, update);
+    }, "📂 Library changes");
+}
+
+void LibraryWatcher::reconcile() {
+    // Full re-diff of every known folder, catching anything the watcher missed
+    const RootModes roots = rootModes;
+    runInBackground([this, roots](TreeUpdate& update) {
+        const QSet<QString> offline = refreshAvailability(roots, update);
+        const QStringList dirs = snapshots.keys();
+        for (const QString& dir : dirs) {
+            if (snapshots.contains(dir))   // may have been dropped with a vanished parent
+                diffDirectory(dir, roots, offline, update);
+        }
+    }, "🔁 Reconciliation");
+}
+
+void LibraryWatcher::checkSuspendedRoots() {
+    // A remounted volume sends no events: poll the suspended roots until they are back
+    const RootModes roots = rootModes;
+    runInBackground([this, roots](TreeUpdate& update) {
+        refreshAvailability(roots, update);
+    }, "🔌 Library roots back");
+}
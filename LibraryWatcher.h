@@ -0,0 +1,95 @@
+#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QThreadPool>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <functional>
+
+// Change feed over the registered library roots.
+// Directory events are debounced and diffed against a per-folder snapshot,
+// so only created/modified and deleted image files reach the scan pipeline.
+// A periodic reconciliation pass catches events lost to watch limits.
+// A root whose folder or volume goes away (unplugged drive, unmounted
+// share) is suspended rather than reported as deleted: its snapshots are
+// kept, nothing is emitted, and it is re-diffed once it is back.
+//
+// Walking trees and diffing snapshots happens on one background thread that
+// owns the snapshots; the GUI thread only adds/removes watched paths and
+// emits the results it is handed back.
+class LibraryWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit LibraryWatcher(QObject* parent = nullptr);
+    ~LibraryWatcher() override;
+
+    // recursive = false watches only the folder itself, not its subfolders
+    void addRoot(const QString& rootPath, bool recursive = true);
+    QStringList roots() const { return rootModes.keys(); }
+
+    void setDebounceInterval(int ms) { debounceTimer.setInterval(ms); }
+    void setReconcileInterval(int ms) { reconcileTimer.setInterval(ms); }
+    void setResumeCheckInterval(int ms) { resumeTimer.setInterval(ms); }
+    void setMaxWatchedFolders(int count) { maxWatchedFolders = count; }
+
+signals:
+    // changed: new or modified images; removed: images that disappeared
+    void filesChanged(const QStringList& changed, const QStringList& removed);
+
+private slots:
+    void onDirectoryChanged(const QString& path);
+    void processPendingDirectories();
+    void reconcile();
+    void checkSuspendedRoots();
+
+private:
+    struct FileStamp {
+        qint64 size = 0;
+        qint64 mtime = 0;
+        bool operator==(const FileStamp& o) const { return size == o.size && mtime == o.mtime; }
+        bool operator!=(const FileStamp& o) const { return !(*this == o); }
+    };
+    using Snapshot = QHash<QString, FileStamp>;   // file name -> stamp
+    using RootModes = QHash<QString, bool>;       // root -> recursive
+
+    // Worker results, applied on the GUI thread
+    struct TreeUpdate {
+        QStringList watch;
+        QStringList unwatch;
+        QStringList changed;
+        QStringList removed;
+        QStringList suspended;      // roots that went offline in this pass
+        QStringList resumed;        // roots that are back
+    };
+
+    // Worker thread only
+    void watchTree(const QString& dirPath, bool recursive, QStringList* createdFiles, TreeUpdate& update);
+    void forgetTree(const QString& dirPath, TreeUpdate& update);
+    void diffDirectory(const QString& dirPath, const RootModes& roots, const QSet<QString>& offline, TreeUpdate& update);
+    QSet<QString> refreshAvailability(const RootModes& roots, TreeUpdate& update);
+    static bool isRecursive(const QString& dirPath, const RootModes& roots);
+    static bool isUnderAny(const QString& dirPath, const QSet<QString>& roots);
+    static Snapshot snapshotOf(const QString& dirPath, QStringList* subdirs = nullptr);
+
+    void runInBackground(const std::function<void(TreeUpdate&)>& work, const char* label);
+    void apply(const TreeUpdate& update, const char* label);
+
+    QFileSystemWatcher watcher;
+    QTimer debounceTimer;
+    QTimer reconcileTimer;
+    QTimer resumeTimer;                     // runs while some root is offline
+    RootModes rootModes;
+    QSet<QString> offlineRoots;             // GUI copy of `suspended`, drives resumeTimer
+    QSet<QString> pendingDirs;
+    int maxWatchedFolders = 8000;
+
+    QThreadPool pool;                       // one thread: owns `snapshots`, runs tasks in order
+    QHash<QString, Snapshot> snapshots;     // watched/known folder -> image files
+    QSet<QString> suspended;                // worker thread: roots whose folder or volume is gone
+};
+
+#endif // LIBRARYWATCHER_H
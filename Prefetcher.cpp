@@ -0,0 +1,261 @@
+#include "Prefetcher.h"
+#include "DirectoryCache.h"
+#include "ThumbnailStore.h"
+#include "ThumbnailCache.h"
+#include "FaceCropStore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QSet>
+#include <QDebug>
+
+Prefetcher::Prefetcher(int thumbnailTier, QObject* parent)
+    : QObject(parent), tier(ThumbnailStore::tierFor(thumbnailTier)) {
+    // ✅ One thread at the lowest priority: never more than a sliver of one core
+    pool.setMaxThreadCount(1);
+    pool.setThreadPriority(QThread::LowestPriority);
+    pool.setObjectName("Prefetcher");
+
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(budget.idleDelayMs);
+    connect(&idleTimer, &QTimer::timeout, this, &Prefetcher::startPass);
+}
+
+Prefetcher::~Prefetcher() {
+    ++generation;
+    pool.clear();
+    pool.waitForDone();
+}
+
+void Prefetcher::setBudget(const PrefetchBudget& newBudget) {
+    budget = newBudget;
+    budget.cpuPercent = qBound(1, budget.cpuPercent, 100);
+    idleTimer.setInterval(budget.idleDelayMs);
+}
+
+void Prefetcher::setTier(int thumbnailTier) {
+    tier = ThumbnailStore::tierFor(thumbnailTier);
+}
+
+void Prefetcher::setForegroundCheck(const std::function<bool()>& check) {
+    foregroundBusy = check;
+}
+
+void Prefetcher::pause() {
+    ++generation;   // the running pass stops at its next step
+    pool.clear();
+    if (!currentFolder.isEmpty())
+        idleTimer.start();
+}
+
+void Prefetcher::setContext(const QString& folder, const QStringList& recentFolders, bool recursive) {
+    currentFolder = folder;
+    history = recentFolders;
+    recursiveFaces = recursive;
+    pause();
+}
+
+bool Prefetcher::takeFaces(const QString& folder, bool recursive, PrefetchedFaces& out) {
+    QMutexLocker locker(&facesMutex);
+    const QString key = facesKey(folder, recursive);
+    auto it = faces.find(key);
+    if (it == faces.end())
+        return false;
+
+    PrefetchedFaces prefetched = it.value();
+    faces.erase(it);
+    facesRecent.removeOne(key);
+
+    // A scan or move committed since the read: the caller queries again
+    if (prefetched.dataVersion != FaceDatabaseManager::instance().dataVersion())
+        return false;
+
+    out = prefetched;
+    return true;
+}
+
+QString Prefetcher::facesKey(const QString& folder, bool recursive) {
+    return QDir::cleanPath(folder) + (recursive ? "|**" : "");
+}
+
+void Prefetcher::startPass() {
+    if (currentFolder.isEmpty())
+        return;
+
+    // Still busy in the foreground: look again after another quiet period
+    if ((foregroundBusy && foregroundBusy()) || QThreadPool::globalInstance()->activeThreadCount() > 0) {
+        idleTimer.start();
+        return;
+    }
+
+    const quint64 pass = generation;
+    pool.start([this, pass, current = currentFolder, recent = history, recursive = recursiveFaces, limits = budget]() {
+        runPass(pass, current, recent, recursive, limits);
+    });
+}
+
+bool Prefetcher::keepGoing(quint64 pass) const {
+    // Anything on the global pool is foreground work (scans, listings, face loads)
+    return pass == generation && QThreadPool::globalInstance()->activeThreadCount() == 0;
+}
+
+bool Prefetcher::throttle(quint64 pass, qint64 bytes, qint64 busyMs, const PrefetchBudget& limits) {
+    // Rest long enough that this step fits both the CPU share and the read rate
+    qint64 restMs = busyMs * (100 - limits.cpuPercent) / limits.cpuPercent;
+    if (limits.bytesPerSecond > 0)
+        restMs = qMax(restMs, bytes * 1000 / limits.bytesPerSecond);
+
+    QElapsedTimer rest;
+    rest.start();
+    while (rest.elapsed() < restMs) {
+        if (!keepGoing(pass)) return false;
+        QThread::msleep(10);
+    }
+    return keepGoing(pass);
+}
+
+QStringList Prefetcher::candidates(const QString& current, const QStringList& recent, int maxFolders) const {
+    const QString prefix = current.endsWith('/') ? current : current + "/";
+
+    // Subfolders that hold images (or were never probed), in view order
+    QStringList children;
+    for (const DirectoryEntry& e : DirectoryCache::instance().list(current).entries) {
+        if (!e.isDir) break;  // folders come first
+        if (e.content != DirectoryEntry::ContentOther && e.content != DirectoryEntry::ContentEmpty)
+            children << prefix + e.name;
+    }
+
+    // Nearest siblings first: the next folder, then the previous one
+    QStringList siblings;
+    QDir parentDir(current);
+    if (parentDir.cdUp() && QDir::cleanPath(parentDir.absolutePath()) != QDir::cleanPath(current)) {
+        const QString parent = parentDir.absolutePath();
+        const QString parentPrefix = parent.endsWith('/') ? parent : parent + "/";
+        const QString name = QFileInfo(QDir::cleanPath(current)).fileName();
+
+        QStringList dirs;
+        for (const DirectoryEntry& e : DirectoryCache::instance().list(parent).entries) {
+            if (!e.isDir) break;
+            if (e.content != DirectoryEntry::ContentOther && e.content != DirectoryEntry::ContentEmpty)
+                dirs << e.name;
+        }
+        int at = dirs.indexOf(name);
+        if (at >= 0) {
+            if (at + 1 < dirs.size()) siblings << parentPrefix + dirs[at + 1];
+            if (at > 0) siblings << parentPrefix + dirs[at - 1];
+        }
+    }
+
+    // History: most recent first
+    QStringList back;
+    for (int i = recent.size() - 1; i >= 0; --i)
+        back << recent[i];
+
+    QStringList ordered;
+    const int firstChildren = maxFolders / 2;
+    ordered << children.mid(0, firstChildren) << siblings << back << children.mid(firstChildren);
+
+    QStringList picked;
+    QSet<QString> seen { QDir::cleanPath(current) };
+    for (const QString& folder : ordered) {
+        if (picked.size() == maxFolders) break;
+        if (seen.contains(QDir::cleanPath(folder))) continue;
+        seen.insert(QDir::cleanPath(folder));
+        picked << folder;
+    }
+    return picked;
+}
+
+void Prefetcher::runPass(quint64 pass, const QString& current, const QStringList& recent, bool recursive, PrefetchBudget limits) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList folders = candidates(current, recent, limits.maxFolders);
+    int done = 0, thumbnails = 0;
+    for (const QString& folder : folders) {
+        if (!QDir(folder).exists()) continue;
+        if (!warmFolder(pass, folder, recursive, limits, thumbnails)) break;
+        ++done;
+    }
+
+    qDebug() << (done == folders.size() ? "🔮 Prefetched" : "⏸️ Prefetch paused after") << done << "of" << folders.size()
+             << "folder(s)," << thumbnails << "thumbnail(s) in" << timer.elapsed() << "ms";
+}
+
+bool Prefetcher::warmFolder(quint64 pass, const QString& folder, bool recursive, const PrefetchBudget& limits, int& thumbnails) {
+    if (!keepGoing(pass)) return false;
+
+    // Face list: summary rows plus exemplar crops, exactly what loadFaceListFromDatabase needs
+    FaceDatabaseManager& db = FaceDatabaseManager::instance();
+    const QString key = facesKey(folder, recursive);
+    bool haveFaces = false;
+    {
+        QMutexLocker locker(&facesMutex);
+        auto it = faces.constFind(key);
+        haveFaces = it != faces.constEnd() && it->dataVersion == db.dataVersion();
+    }
+    if (!haveFaces) {
+        QElapsedTimer busy;
+        busy.start();
+
+        PrefetchedFaces prefetched;
+        prefetched.dataVersion = db.dataVersion();
+        prefetched.people = db.folderPersonSummary(folder, recursive);
+        QList<FaceCropRequest> requests;
+        for (const FolderPerson& person : prefetched.people)
+            requests.append({ person.bestFaceId, person.bestImagePath, person.bestFaceRect });
+        qint64 cropBytes = 0;
+        prefetched.crops = FaceCropStore::instance().load(requests, &cropBytes);
+
+        {
+            QMutexLocker locker(&facesMutex);
+            faces.insert(key, prefetched);
+            facesRecent.removeOne(key);
+            facesRecent.append(key);
+            while (facesRecent.size() > maxFaceLists)
+                faces.remove(facesRecent.takeFirst());
+        }
+        if (!throttle(pass, cropBytes, busy.elapsed(), limits)) return false;
+    }
+
+    // First screen of thumbnails: into the pack if missing, into memory either way
+    DirectoryListing listing = DirectoryCache::instance().list(folder);
+    const int edge = tier;
+    const QString warmedKey = QString::number(edge) + '@' + folder;
+    if (warmed.value(warmedKey, -1) == listing.dirMtime)
+        return true;
+
+    const QString prefix = folder.endsWith('/') ? folder : folder + "/";
+    int count = 0;
+    for (const DirectoryEntry& e : listing.entries) {
+        if (e.isDir) continue;
+        if (count == limits.thumbnailsPerFolder) break;
+        if (!keepGoing(pass)) return false;
+
+        QElapsedTimer busy;
+        busy.start();
+
+        const QString path = prefix + e.name;
+        QFileInfo info(path);
+        qint64 read = 0;
+        QImage image = ThumbnailStore::instance().find(info, edge);
+        if (image.isNull()) {
+            image = ThumbnailStore::instance().thumbnail(info, edge);
+            read = info.size();
+        }
+        if (!image.isNull())
+            ThumbnailCache::instance().insert(path, info.lastModified().toMSecsSinceEpoch(), edge, image);
+
+        ++count;
+        ++thumbnails;
+        if (!throttle(pass, read, busy.elapsed(), limits)) return false;
+    }
+
+    if (warmed.size() > 4096)
+        warmed.clear();  // only saves re-checking; forgetting is harmless
+    warmed.insert(warmedKey, listing.dirMtime);
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QStringList>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include "FaceDatabaseManager.h"
+
+// Budgets for one idle pass; the pass runs on a single low-priority thread
+struct PrefetchBudget {
+    int idleDelayMs = 1500;                     // quiet time before a pass starts
+    qint64 bytesPerSecond = 8ll * 1024 * 1024;  // source bytes read for thumbnails and crops
+    int cpuPercent = 25;                        // share of one core while running
+    int maxFolders = 8;
+    int thumbnailsPerFolder = 32;               // about the first screen of each folder
+};
+
+// Face list of a folder, read ahead of navigation
+struct PrefetchedFaces {
+    QList<FolderPerson> people;
+    QHash<qint64, QImage> crops;
+    quint64 dataVersion = 0;    // FaceDatabaseManager::dataVersion() before the query
+};
+
+// Warms the folders the user is likely to open next while the window is
+// idle: subfolders of the current folder, its nearest siblings, then recent
+// history. For each one it lists the folder through DirectoryCache, makes
+// sure the first screen of thumbnails is in ThumbnailStore and ThumbnailCache,
+// and reads the face summary with its crops so the next loadFaceListFromDatabase
+// is a hash lookup.
+//
+// Strictly best-effort: a pass starts only after idleDelayMs without
+// foreground work, reads at most bytesPerSecond, sleeps so it uses at most
+// cpuPercent of one core, and stops at its next step once pause() is called
+// or anything runs on the global thread pool (scans, listings, face loads).
+// It never uses the global pool itself. Called from the GUI thread only.
+class Prefetcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit Prefetcher(int tier, QObject* parent = nullptr);
+    ~Prefetcher();
+
+    void setBudget(const PrefetchBudget& budget);
+
+    // Thumbnail tier the folder view shows; later passes warm that one
+    void setTier(int tier);
+
+    // Extra "busy" test run on the GUI thread before a pass starts (e.g. thumbnails pending)
+    void setForegroundCheck(const std::function<bool()>& check);
+
+    // Foreground work started: the running pass stops, the idle countdown restarts
+    void pause();
+
+    // Where the user is; the candidates are recomputed and a pass is scheduled
+    void setContext(const QString& currentFolder, const QStringList& history, bool recursiveFaces);
+
+    // Prefetched face list of `folder` if no face data changed since it was read; handed out once
+    bool takeFaces(const QString& folder, bool recursive, PrefetchedFaces& faces);
+
+private:
+    void startPass();
+    void runPass(quint64 pass, const QString& current, const QStringList& history, bool recursive, PrefetchBudget budget);
+    QStringList candidates(const QString& current, const QStringList& history, int maxFolders) const;
+    bool warmFolder(quint64 pass, const QString& folder, bool recursive, const PrefetchBudget& budget, int& thumbnails);
+    bool throttle(quint64 pass, qint64 bytes, qint64 busyMs, const PrefetchBudget& budget);
+    bool keepGoing(quint64 pass) const;
+    static QString facesKey(const QString& folder, bool recursive);
+
+    static constexpr int maxFaceLists = 8;
+
+    std::atomic<int> tier;
+    QThreadPool pool;
+    QTimer idleTimer;
+    PrefetchBudget budget;
+    std::function<bool()> foregroundBusy;
+    std::atomic<quint64> generation { 0 };
+
+    QString currentFolder;
+    QStringList history;
+    bool recursiveFaces = false;
+
+    QHash<QString, qint64> warmed;     // "<tier>@<folder>" -> folder mtime when warmed; pool thread only
+
+    QMutex facesMutex;
+    QHash<QString, PrefetchedFaces> faces;
+    QStringList facesRecent;           // most recently prefetched last
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,150 @@
+#include "ScanJob.h"
+#include "FaceWriteQueue.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QDebug>
+
+static QString encodeOptions(const ScanOptions& options, bool recursive) {
+    return QString("resize=%1;jitter=%2;recursive=%3")
+        .arg(resizeModeName(options.resizeMode)).arg(options.jitter ? 1 : 0).arg(recursive ? 1 : 0);
+}
+
+static ScanOptions decodeOptions(const QString& text) {
+    ScanOptions options;
+    for (const QString& pair : text.split(';', Qt::SkipEmptyParts)) {
+        QString key = pair.section('=', 0, 0);
+        QString value = pair.section('=', 1);
+        if (key == "resize")
+            resizeModeFromName(value, options.resizeMode);
+        else if (key == "jitter")
+            options.jitter = value != "0";
+    }
+    return options;
+}
+
+qint64 ScanJob::create(const QStringList& roots, const ScanOptions& options, bool recursive) {
+    return FaceDatabaseManager::instance().createScanJob(roots, encodeOptions(options, recursive));
+}
+
+qint64 ScanJob::latestUnfinished() {
+    return FaceDatabaseManager::instance().latestUnfinishedScanJob();
+}
+
+ScanJob::ScanJob(qint64 jobId) {
+    if (!FaceDatabaseManager::instance().loadScanJob(jobId, record)) {
+        qWarning() << "❌ Unknown scan job:" << jobId;
+        record = ScanJobRecord();
+        return;
+    }
+
+    recursive = !record.options.contains("recursive=0");
+    resumeSeq = cursor = watermark = record.watermark;
+    if (resumeSeq > 0)
+        qDebug() << "🔁 Resuming scan job" << jobId << "at file" << resumeSeq << "of" << record.fileCount;
+
+    // ✅ Only writes dropped from here on concern this run (and stop its checkpoints)
+    writeMark = FaceWriteQueue::instance().beginJob(jobId);
+}
+
+ScanJob::~ScanJob() {
+    if (isValid())
+        FaceWriteQueue::instance().endJob(record.jobId);
+}
+
+ScanOptions ScanJob::options() const {
+    return decodeOptions(record.options);
+}
+
+bool ScanJob::enumerate() {
+    if (!isValid()) return false;
+    if (record.state != "enumerating") return true;
+
+    FaceDatabaseManager& db = FaceDatabaseManager::instance();
+    const QStringList filters = ScanPipeline::imageNameFilters();
+
+    QElapsedTimer timer;
+    timer.start();
+    int dirCount = 0;
+
+    // ✅ Breadth-first over the persisted frontier; each directory commits on its own
+    while (true) {
+        QStringList pending = db.pendingScanJobDirs(record.jobId, 64);
+        if (pending.isEmpty()) break;
+
+        for (const QString& dirPath : pending) {
+            QDir dir(dirPath);
+            QStringList files, subdirs;
+
+            // A folder deleted since it was queued is simply recorded as empty
+            if (dir.exists()) {
+                for (const QString& name : dir.entryList(filters, QDir::Files, QDir::Name))
+                    files << dir.filePath(name);
+                if (recursive) {
+                    for (const QString& name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDir::Name))
+                        subdirs << dir.filePath(name);
+                }
+            }
+
+            if (!db.recordScanJobDir(record.jobId, dirPath, files, subdirs))
+                return false;
+
+            if (++dirCount % 500 == 0)
+                qDebug() << "📂 Enumerated" << dirCount << "folder(s) in" << timer.elapsed() << "ms";
+        }
+    }
+
+    if (!db.setScanJobState(record.jobId, "running") || !db.loadScanJob(record.jobId, record))
+        return false;
+
+    qDebug() << "📂 Scan job" << record.jobId << "enumerated" << record.fileCount << "file(s) in" << timer.elapsed() << "ms";
+    return true;
+}
+
+ScanJobBatch ScanJob::nextBatch(int maxFiles) {
+    QMutexLocker locker(&mutex);
+
+    ScanJobBatch batch;
+    if (!isValid() || cursor >= record.fileCount)
+        return batch;
+
+    batch.firstSeq = cursor;
+    batch.paths = FaceDatabaseManager::instance().scanJobFiles(record.jobId, cursor, maxFiles);
+    cursor = batch.endSeq();
+    return batch;
+}
+
+void ScanJob::completeBatch(const ScanJobBatch& batch) {
+    if (batch.isEmpty()) return;
+
+    QMutexLocker locker(&mutex);
+    completed.insert(batch.firstSeq, batch.endSeq());
+
+    // Batches finish out of order; only a gap-free prefix may be checkpointed
+    qint64 before = watermark;
+    while (!completed.isEmpty() && completed.firstKey() == watermark)
+        watermark = completed.take(watermark);
+
+    // Queued behind the faces of these files, so it commits with (or after) them
+    if (watermark > before)
+        FaceWriteQueue::instance().enqueueCheckpoint(record.jobId, watermark);
+}
+
+bool ScanJob::finish() {
+    if (!isValid()) return false;
+
+    // A dropped write since the job started means some files are not indexed: the job stays resumable
+    if (!FaceWriteQueue::instance().flush(writeMark)) {
+        qWarning() << "⚠️ Scan job" << record.jobId << "has writes that failed to commit";
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (watermark < record.fileCount) {
+        qWarning() << "⚠️ Scan job" << record.jobId << "stopped at" << watermark << "of" << record.fileCount << "file(s)";
+        return false;
+    }
+
+    record.state = "done";
+    return FaceDatabaseManager::instance().setScanJobState(record.jobId, "done");
+}
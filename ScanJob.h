@@ -0,0 +1,68 @@
+#ifndef SCANJOB_H
+#define SCANJOB_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QMutex>
+#include "FaceDatabaseManager.h"
+#include "ScanPipeline.h"
+
+// A contiguous slice of a job's numbered file list
+struct ScanJobBatch {
+    qint64 firstSeq = 0;
+    QStringList paths;
+
+    qint64 endSeq() const { return firstSeq + paths.size(); }
+    bool isEmpty() const { return paths.isEmpty(); }
+};
+
+// Crash-safe long scan. The job row, its directory frontier and its file list
+// live in SQLite: enumeration resumes at the first unlisted directory, and the
+// watermark (files below it are fully committed) travels through FaceWriteQueue
+// so it commits in the same transaction as the faces it covers.
+class ScanJob {
+public:
+    // recursive = false scans exactly the given folders (shard manifests)
+    static qint64 create(const QStringList& roots, const ScanOptions& options, bool recursive = true);
+    static qint64 latestUnfinished();
+
+    explicit ScanJob(qint64 jobId);
+    ~ScanJob();
+    ScanJob(const ScanJob&) = delete;
+    ScanJob& operator=(const ScanJob&) = delete;
+
+    bool isValid() const { return record.jobId > 0; }
+    qint64 id() const { return record.jobId; }
+    QStringList roots() const { return record.roots; }
+    ScanOptions options() const;
+    bool isDone() const { return record.state == "done"; }
+    qint64 fileCount() const { return record.fileCount; }
+    qint64 resumedAt() const { return resumeSeq; }
+    bool isRecursive() const { return recursive; }
+
+    // Lists the remaining directories; safe to interrupt at any point
+    bool enumerate();
+
+    // Thread-safe; hands out the next unprocessed files, empty once exhausted
+    ScanJobBatch nextBatch(int maxFiles);
+
+    // Call after every file of the batch went through ScanPipeline::processFile
+    void completeBatch(const ScanJobBatch& batch);
+
+    // Waits for the last checkpoint and marks the job done; false if any of
+    // the job's writes were dropped or files are left
+    bool finish();
+
+private:
+    QMutex mutex;
+    ScanJobRecord record;
+    bool recursive = true;
+    qint64 resumeSeq = 0;
+    quint64 writeMark = 0;              // FaceWriteQueue mark when the job started
+    qint64 cursor = 0;                  // next seq to hand out
+    qint64 watermark = 0;               // every seq below is processed
+    QMap<qint64, qint64> completed;     // finished batches past the watermark: first -> end
+};
+
+#endif // SCANJOB_H
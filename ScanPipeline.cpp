@@ -0,0 +1,324 @@
+#include "ScanPipeline.h"
+#include "FaceDatabaseManager.h"
+#include "FaceWriteQueue.h"
+#include "ImageFingerprint.h"
+#include "FaceCropStore.h"
+
+#include <QFileInfo>
+#include <QDir>
+#include <QStorageInfo>
+#include <QDateTime>
+#include <QDebug>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+QString resizeModeName(ResizeMode mode) {
+    switch (mode) {
+    case ResizeMode::Fit1024x1024: return "1024";
+    case ResizeMode::Fit1280x720:  return "1280x720";
+    default:                       return "original";
+    }
+}
+
+bool resizeModeFromName(const QString& name, ResizeMode& mode) {
+    if (name == "original") mode = ResizeMode::Original;
+    else if (name == "1024") mode = ResizeMode::Fit1024x1024;
+    else if (name == "1280x720") mode = ResizeMode::Fit1280x720;
+    else return false;
+    return true;
+}
+
+static QSize detectionSize(const QSize& imageSize, ResizeMode mode) {
+    if (mode == ResizeMode::Original)
+        return imageSize;
+
+    int maxWidth, maxHeight;
+    if (mode == ResizeMode::Fit1024x1024) {
+        maxWidth = 1024;
+        maxHeight = 1024;
+    } else { // Fit1280x720
+        maxWidth = 1280;
+        maxHeight = 720;
+    }
+
+    double scale = std::min((double)maxWidth / imageSize.width(), (double)maxHeight / imageSize.height());
+    return QSize(static_cast<int>(imageSize.width() * scale), static_cast<int>(imageSize.height() * scale));
+}
+
+QSizeF detectionScale(const QSize& imageSize, ResizeMode mode) {
+    QSize resized = detectionSize(imageSize, mode);
+    if (resized.isEmpty())
+        return QSizeF(1.0, 1.0);
+    return QSizeF((double)imageSize.width() / resized.width(), (double)imageSize.height() / resized.height());
+}
+
+cv::Mat resizeImageForDetection(const cv::Mat& input, ResizeMode mode,
+                                cv::Size& newSize, double& scaleX, double& scaleY) {
+    if (mode == ResizeMode::Original) {
+        newSize = input.size();
+        scaleX = 1.0;
+        scaleY = 1.0;
+        return input.clone();
+    }
+
+    QSize resizedSize = detectionSize(QSize(input.cols, input.rows), mode);
+    cv::Mat resized;
+    cv::resize(input, resized, cv::Size(resizedSize.width(), resizedSize.height()), 0, 0, cv::INTER_AREA);
+
+    QSizeF scale = detectionScale(QSize(input.cols, input.rows), mode);
+    scaleX = scale.width();
+    scaleY = scale.height();
+    newSize = resized.size();
+
+    return resized;
+}
+
+bool eyesAreOpen(const dlib::full_object_detection& shape) {
+    auto eyeOpenness = [&](int top1, int top2, int bottom1, int bottom2) {
+        return (shape.part(bottom1).y() + shape.part(bottom2).y()) -
+               (shape.part(top1).y() + shape.part(top2).y());
+    };
+
+    double leftEye = eyeOpenness(37, 38, 41, 40);  // left eye
+    double rightEye = eyeOpenness(43, 44, 47, 46); // right eye
+
+    double eyeOpenScore = (leftEye + rightEye) / 2.0;
+    return eyeOpenScore > 4.0;  // adjust threshold if needed
+}
+
+double getSymmetryScore(const dlib::full_object_detection& shape) {
+    double eyeCenter = (shape.part(36).x() + shape.part(45).x()) / 2.0;
+    double noseX = shape.part(30).x();
+    return std::abs(eyeCenter - noseX);  // smaller = more frontal
+}
+
+double getFocusScore(const cv::Mat& faceMat) {
+    cv::Mat gray, lap;
+    cv::cvtColor(faceMat, gray, cv::COLOR_BGR2GRAY);
+    cv::Laplacian(gray, lap, CV_64F);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(lap, mean, stddev);
+    return stddev[0] * stddev[0];  // variance = sharpness
+}
+
+ScanPipeline::ScanPipeline(const ScanOptions& opts) : options(opts) {}
+
+void ScanPipeline::setOptions(const ScanOptions& opts) {
+    QMutexLocker locker(&mutex);
+    options = opts;
+}
+
+bool ScanSession::claim(const QString& hash, const QString& path, QString* firstPath) {
+    QMutexLocker locker(&mutex);
+    while (true) {
+        auto it = firstPaths.constFind(hash);
+        if (it == firstPaths.constEnd()) {
+            firstPaths.insert(hash, path);
+            pending.insert(hash, 1);
+            return true;
+        }
+        if (!pending.contains(hash)) {
+            *firstPath = it.value();
+            return false;
+        }
+        released.wait(&mutex);  // claimant still analysing; it may also fail and free the hash
+    }
+}
+
+void ScanSession::release(const QString& hash, bool queued) {
+    QMutexLocker locker(&mutex);
+    pending.remove(hash);
+    if (!queued)
+        firstPaths.remove(hash);
+    released.wakeAll();
+}
+
+void ScanSession::clear() {
+    QMutexLocker locker(&mutex);
+    firstPaths.clear();
+    pending.clear();
+    released.wakeAll();
+}
+
+void ScanPipeline::resetSession() {
+    QMutexLocker locker(&mutex);
+    session->clear();
+}
+
+void ScanPipeline::setSession(const std::shared_ptr<ScanSession>& shared) {
+    QMutexLocker locker(&mutex);
+    session = shared;
+}
+
+// The one list of indexed image types; name filters and isImageFile() both derive from it
+static constexpr const char16_t* IMAGE_EXTENSIONS[] = { u"jpg", u"jpeg", u"png", u"bmp" };
+
+QStringList ScanPipeline::imageNameFilters() {
+    QStringList filters;
+    for (const char16_t* ext : IMAGE_EXTENSIONS)
+        filters << "*." + QString::fromUtf16(ext);
+    return filters;
+}
+
+// ✅ No QFileInfo or lowercase copy: folder listings call this for every entry
+bool ScanPipeline::isImageFile(const QString& path) {
+    int dot = path.lastIndexOf('.');
+    if (dot < 0) return false;
+
+    QStringView ext = QStringView(path).mid(dot + 1);
+    for (const char16_t* known : IMAGE_EXTENSIONS) {
+        if (ext.compare(QStringView(known), Qt::CaseInsensitive) == 0)
+            return true;
+    }
+    return false;
+}
+
+QString ScanPipeline::libraryRootOf(const QString& path, const QStringList& roots) {
+    QString best;
+    for (const QString& root : roots) {
+        if ((path == root || path.startsWith(root + "/")) && root.length() > best.length())
+            best = root;
+    }
+    return best;
+}
+
+bool ScanPipeline::isLibraryRootAvailable(const QString& root) {
+    if (!QFileInfo(root).isDir())
+        return false;
+
+    QStorageInfo volume(root);
+    if (!volume.isValid() || !volume.isReady())
+        return false;
+
+    // An unmounted volume often leaves its mount point behind as an empty folder
+    return !QDir(root).isEmpty();
+}
+
+ScanResult ScanPipeline::processFile(const QString& path) {
+    QMutexLocker locker(&mutex);
+
+    ScanResult result;
+    result.path = path;
+
+    QFileInfo info(path);
+    qint64 mtime = info.lastModified().toSecsSinceEpoch();
+    if (FaceDatabaseManager::instance().faceAlreadyProcessed(path, mtime)) {
+        qDebug() << "⏭️ Skipping cached:" << path;
+        return result;
+    }
+
+    ImageRecord record;
+    record.imagePath = path;
+    record.mtime = mtime;
+    record.fileSize = info.size();
+    record.fileId = fileIdentity(path);
+
+    // ✅ Renamed/moved outside the app: same inode, size and mtime -> just rewrite the path
+    QString movedFrom = FaceDatabaseManager::instance().findMovedImage(record);
+    if (!movedFrom.isEmpty() && FaceDatabaseManager::instance().movePath(movedFrom, path)) {
+        qDebug() << "🚚 Detected rename" << movedFrom << "->" << path;
+        result.outcome = ScanOutcome::Moved;
+        return result;
+    }
+
+    record.contentHash = quickContentHash(path, record.fileSize);
+
+    // ✅ Same bytes already analysed under another path (by any worker of this scan): share its faces
+    QString duplicateOf;
+    const bool claimed = !record.contentHash.isEmpty() && session->claim(record.contentHash, path, &duplicateOf);
+    if (!duplicateOf.isEmpty()) {
+        record.fullHash = fullContentHash(path);
+        if (record.fullHash.isEmpty() || fullContentHash(duplicateOf) != record.fullHash)
+            duplicateOf.clear();
+    }
+    if (duplicateOf.isEmpty())
+        duplicateOf = FaceDatabaseManager::instance().findImageWithContent(record);
+
+    if (!duplicateOf.isEmpty()) {
+        qDebug() << "♻️ Identical to already indexed" << duplicateOf << "->" << path;
+        FaceWriteQueue::instance().enqueueClone(record, duplicateOf);
+        if (claimed)
+            session->release(record.contentHash, true);
+        result.outcome = ScanOutcome::Duplicate;
+        return result;
+    }
+
+    result = analyse(path, record);
+    if (claimed)
+        session->release(record.contentHash, result.outcome != ScanOutcome::Failed);
+    return result;
+}
+
+ScanResult ScanPipeline::analyse(const QString& path, ImageRecord& record) {
+    ScanResult result;
+    result.path = path;
+    result.outcome = ScanOutcome::Failed;
+
+    cv::Mat fullRes = cv::imread(path.toStdString());
+    if (fullRes.empty()) return result;
+
+    cv::Size resizedSize;
+    double scaleX = 1.0, scaleY = 1.0;
+    cv::Mat matBGR = resizeImageForDetection(fullRes, options.resizeMode, resizedSize, scaleX, scaleY);
+
+    if (matBGR.empty()) return result;
+
+    auto faces = detector.detectFaces(matBGR);
+    qDebug() << "🧠" << faces.size() << "face(s) found in:" << path;
+
+    QList<FaceEntry> faceEntries;
+    QList<std::vector<float>> embeddingList;
+    QList<QByteArray> crops;
+
+    for (const QRect& rect : faces) {
+        auto embedding = options.jitter ? detector.getJitteredEmbedding(matBGR, rect)
+                                        : detector.getFaceEmbedding(matBGR, rect);
+        if (embedding.empty()) continue;
+        qDebug() << "📸 In file:" << path << "📐 Face Size:" << rect.width() << "x" << rect.height();
+
+        if (rect.width() < 20 || rect.height() < 20) continue;
+        if (rect.width() > 1000 || rect.height() > 1000) continue;
+
+        dlib::rectangle dlibRect(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height());
+        dlib::cv_image<dlib::bgr_pixel> dlibImg(matBGR);
+        auto shape = detector.getLandmarks(dlibImg, dlibRect);
+
+        QRect scaled(
+            int(rect.x() * scaleX),
+            int(rect.y() * scaleY),
+            int(rect.width() * scaleX),
+            int(rect.height() * scaleY)
+            );
+
+        cv::Rect roi(scaled.x(), scaled.y(), scaled.width(), scaled.height());
+        roi &= cv::Rect(0, 0, fullRes.cols, fullRes.rows);
+        cv::Mat faceMat = fullRes(roi).clone();
+        cv::resize(faceMat, faceMat, cv::Size(64, 64));
+
+        ScannedFace face;
+        face.rect = rect;
+        face.embedding = embedding;
+        face.symmetry = getSymmetryScore(shape);
+        face.focus = getFocusScore(faceMat);
+        face.eyesOpen = eyesAreOpen(shape);
+        face.thumb = QImage(faceMat.data, faceMat.cols, faceMat.rows, faceMat.step, QImage::Format_BGR888).copy();
+        result.faces.append(face);
+
+        FaceEntry entry;
+        entry.imagePath = path;
+        entry.faceRect = rect;
+        entry.quality = face.focus;
+        entry.globalId = "";  // leave empty for now
+        faceEntries.append(entry);
+        embeddingList.append(embedding);
+        crops.append(FaceCropStore::encode(face.thumb));  // encoded here, off the writer thread
+    }
+
+    // ✅ Hand off to the writer thread; it group-commits many images per transaction.
+    // Images without faces are recorded too, so they are not re-detected next time.
+    FaceWriteQueue::instance().enqueue(record, faceEntries, embeddingList, crops);
+
+    result.outcome = ScanOutcome::Analysed;
+    return result;
+}
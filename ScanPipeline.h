@@ -0,0 +1,113 @@
+#ifndef SCANPIPELINE_H
+#define SCANPIPELINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QSizeF>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+#include <vector>
+#include "faceDetector.h"
+#include "FaceTypes.h"
+
+enum class ResizeMode {
+    Original,
+    Fit1024x1024,
+    Fit1280x720
+};
+
+// "original", "1024", "1280x720" (CLI and scan job records)
+QString resizeModeName(ResizeMode mode);
+bool resizeModeFromName(const QString& name, ResizeMode& mode);
+
+// Factors from detection-image coordinates (where face rects are stored) back to the decoded image
+QSizeF detectionScale(const QSize& imageSize, ResizeMode mode);
+
+struct ScanOptions {
+    ResizeMode resizeMode = ResizeMode::Original;
+    bool jitter = true;         // 10-jitter embeddings (slower, more robust)
+};
+
+// One detected face plus the scores the UI uses to choose exemplars
+struct ScannedFace {
+    QRect rect;
+    std::vector<float> embedding;
+    double symmetry = 0.0;
+    double focus = 0.0;
+    bool eyesOpen = false;
+    QImage thumb;               // 64x64 crop from the full-resolution image
+};
+
+enum class ScanOutcome {
+    Skipped,        // unchanged since the last scan
+    Moved,          // external rename, index rows rewritten
+    Duplicate,      // identical to an indexed file, faces shared
+    Failed,         // unreadable image
+    Analysed        // decoded and run through detection
+};
+
+struct ScanResult {
+    ScanOutcome outcome = ScanOutcome::Skipped;
+    QString path;
+    QList<ScannedFace> faces;
+};
+
+// Content hashes seen during one scan, shared by every pipeline of that scan
+// so a copy is recognised even when its original went to another worker.
+// The first path to claim a hash analyses it; later claims wait until its
+// write is queued, so their clones always commit after the rows they copy.
+class ScanSession {
+public:
+    // true: the caller owns `hash` and must call release(). false: *firstPath analysed it first.
+    bool claim(const QString& hash, const QString& path, QString* firstPath);
+    void release(const QString& hash, bool queued);
+    void clear();
+
+private:
+    QMutex mutex;
+    QWaitCondition released;
+    QHash<QString, QString> firstPaths;     // quick hash -> first path claimed this session
+    QHash<QString, int> pending;            // hashes whose claimant has not queued its write yet
+};
+
+// Per-image indexing step shared by the manual scan and the file watcher:
+// skip/rename/dedup checks, then detection + embedding. Results are queued on
+// FaceWriteQueue. Calls are serialized because the dlib models are not thread-safe.
+class ScanPipeline {
+public:
+    explicit ScanPipeline(const ScanOptions& options = ScanOptions());
+
+    void setOptions(const ScanOptions& options);
+    ScanResult processFile(const QString& path);
+
+    // Forgets the per-scan content map used to spot copies within one run
+    void resetSession();
+
+    // Parallel scans: give every worker's pipeline the same session
+    void setSession(const std::shared_ptr<ScanSession>& session);
+
+    static bool isImageFile(const QString& path);
+    static QStringList imageNameFilters();
+
+    // Registered root a path lives under (the deepest one), or empty
+    static QString libraryRootOf(const QString& path, const QStringList& roots);
+
+    // False while the root folder or the volume holding it is gone (unplugged
+    // drive, unmounted share): its files are then missing, not deleted
+    static bool isLibraryRootAvailable(const QString& root);
+
+private:
+    ScanResult analyse(const QString& path, ImageRecord& record);
+
+    QMutex mutex;
+    ScanOptions options;
+    FaceDetector detector;
+    std::shared_ptr<ScanSession> session = std::make_shared<ScanSession>();
+};
+
+#endif // SCANPIPELINE_H
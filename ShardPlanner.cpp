@@ -0,0 +1,109 @@
+#include "ShardPlanner.h"
+#include "ScanPipeline.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+ShardPlan ShardPlanner::plan(const QStringList& roots, int shardCount) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ShardPlan result;
+    shardCount = qMax(1, shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        result.shardFolders.append(QStringList());
+        result.shardImages.append(0);
+    }
+
+    // ✅ Count images per folder (each root plus every folder below it)
+    const QStringList filters = ScanPipeline::imageNameFilters();
+    QList<QPair<qint64, QString>> folders;
+    for (const QString& root : roots) {
+        QStringList dirs { QDir::cleanPath(QFileInfo(root).absoluteFilePath()) };
+        result.roots << dirs.first();
+        QDirIterator it(dirs.first(), QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            dirs << QDir::cleanPath(it.next());
+
+        for (const QString& dir : dirs) {
+            qint64 images = QDir(dir).entryList(filters, QDir::Files).size();
+            if (images > 0)
+                folders.append({ images, dir });
+        }
+    }
+
+    // ✅ Largest folder first onto the least loaded shard (LPT scheduling)
+    std::sort(folders.begin(), folders.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    for (const auto& folder : folders) {
+        int target = static_cast<int>(std::min_element(result.shardImages.begin(), result.shardImages.end())
+                                      - result.shardImages.begin());
+        result.shardFolders[target] << folder.second;
+        result.shardImages[target] += folder.first;
+        result.totalImages += folder.first;
+    }
+
+    for (QStringList& list : result.shardFolders)
+        list.sort();
+
+    qDebug() << "🧩 Planned" << shardCount << "shard(s) over" << folders.size() << "folder(s),"
+             << result.totalImages << "image(s) in" << timer.elapsed() << "ms";
+    return result;
+}
+
+QStringList ShardPlanner::writeManifests(const ShardPlan& plan, const QString& outDir) {
+    QStringList written;
+    if (!QDir().mkpath(outDir)) {
+        qWarning() << "❌ Cannot create manifest folder:" << outDir;
+        return written;
+    }
+
+    int shardCount = plan.shardFolders.size();
+    for (int i = 0; i < shardCount; ++i) {
+        QString path = QDir(outDir).filePath(QString("shard-%1.manifest").arg(i + 1));
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qWarning() << "❌ Cannot write manifest:" << path << file.errorString();
+            return QStringList();
+        }
+
+        QTextStream out(&file);
+        out << "# photoexplorer-index shard " << (i + 1) << "/" << shardCount
+            << ", " << plan.shardImages[i] << " image(s)\n";
+        for (const QString& root : plan.roots)
+            out << "# root: " << root << "\n";
+        for (const QString& folder : plan.shardFolders[i])
+            out << folder << "\n";
+        written << path;
+    }
+    return written;
+}
+
+QStringList ShardPlanner::readManifest(const QString& manifestPath, QStringList* roots, bool* ok) {
+    QStringList folders;
+    QFile file(manifestPath);
+    bool opened = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    if (ok) *ok = opened;
+    if (!opened) {
+        qWarning() << "❌ Cannot read manifest:" << manifestPath << file.errorString();
+        return folders;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.startsWith("# root: ")) {
+            if (roots) *roots << line.mid(8);
+        } else if (!line.isEmpty() && !line.startsWith('#')) {
+            folders << line;
+        }
+    }
+    return folders;
+}
@@ -0,0 +1,29 @@
+#ifndef SHARDPLANNER_H
+#define SHARDPLANNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// Work split for multi-process indexing: every folder under the roots goes to
+// exactly one shard, balanced by image count. Each shard indexes its folders
+// (non-recursively) into its own SQLite file; FaceDatabaseManager::mergeShard
+// folds the shard files back into the main database.
+struct ShardPlan {
+    QStringList roots;
+    QList<QStringList> shardFolders;
+    QList<qint64> shardImages;
+    qint64 totalImages = 0;
+};
+
+class ShardPlanner {
+public:
+    static ShardPlan plan(const QStringList& roots, int shardCount);
+
+    // One "shard-<k>.manifest" per shard: comment header with the library roots,
+    // then one folder per line
+    static QStringList writeManifests(const ShardPlan& plan, const QString& outDir);
+    static QStringList readManifest(const QString& manifestPath, QStringList* roots = nullptr, bool* ok = nullptr);
+};
+
+#endif // SHARDPLANNER_H
@@ -0,0 +1,65 @@
+#include "ThumbnailCache.h"
+
+ThumbnailCache& ThumbnailCache::instance() {
+    static ThumbnailCache inst;
+    return inst;
+}
+
+void ThumbnailCache::setBudget(qint64 bytes) {
+    QMutexLocker locker(&mutex);
+    budget = qMax<qint64>(0, bytes);
+    evictToBudget();
+}
+
+QImage ThumbnailCache::find(const QString& path, qint64 mtime, int edge) {
+    QMutexLocker locker(&mutex);
+    auto it = index.constFind({ path, mtime, edge });
+    if (it == index.constEnd()) {
+        ++counters.misses;
+        return QImage();
+    }
+
+    ++counters.hits;
+    lru.splice(lru.begin(), lru, it.value());  // iterators stay valid
+    return it.value()->image;
+}
+
+void ThumbnailCache::insert(const QString& path, qint64 mtime, int edge, const QImage& image) {
+    if (image.isNull()) return;
+
+    const Key key { path, mtime, edge };
+    const qint64 cost = image.sizeInBytes();
+
+    QMutexLocker locker(&mutex);
+    if (cost > budget) return;
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        counters.bytes -= it.value()->cost;
+        lru.erase(it.value());
+        index.erase(it);
+    }
+
+    lru.push_front({ key, image, cost });
+    index.insert(key, lru.begin());
+    counters.bytes += cost;
+    evictToBudget();
+}
+
+void ThumbnailCache::evictToBudget() {
+    while (counters.bytes > budget && !lru.empty()) {
+        const Node& last = lru.back();
+        counters.bytes -= last.cost;
+        index.remove(last.key);
+        lru.pop_back();
+        ++counters.evictions;
+    }
+}
+
+ThumbnailCacheStats ThumbnailCache::stats() const {
+    QMutexLocker locker(&mutex);
+    ThumbnailCacheStats s = counters;
+    s.budget = budget;
+    s.entries = index.size();
+    return s;
+}
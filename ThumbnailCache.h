@@ -0,0 +1,69 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QString>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <list>
+
+struct ThumbnailCacheStats {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+    qint64 bytes = 0;           // decoded bytes currently held
+    qint64 budget = 0;
+    int entries = 0;
+};
+
+// Process-wide LRU of decoded thumbnails, bounded by decoded bytes
+// (QImage::sizeInBytes), so revisiting a recent folder paints without any
+// disk access. Keyed by path + source mtime + box edge: an edited photo
+// misses instead of showing the old thumbnail. Thread-safe.
+class ThumbnailCache {
+public:
+    static constexpr qint64 defaultBudget = 64ll * 1024 * 1024;
+
+    static ThumbnailCache& instance();
+
+    // Shrinking the budget evicts right away
+    void setBudget(qint64 bytes);
+
+    // Null image on a miss; a hit becomes the most recently used entry
+    QImage find(const QString& path, qint64 mtime, int edge);
+
+    void insert(const QString& path, qint64 mtime, int edge, const QImage& image);
+
+    ThumbnailCacheStats stats() const;
+
+private:
+    ThumbnailCache() = default;
+
+    struct Key {
+        QString path;
+        qint64 mtime;
+        int edge;
+        bool operator==(const Key& other) const {
+            return mtime == other.mtime && edge == other.edge && path == other.path;
+        }
+    };
+    friend size_t qHash(const Key& key, size_t seed) {
+        return qHashMulti(seed, key.path, key.mtime, key.edge);
+    }
+
+    struct Node {
+        Key key;
+        QImage image;
+        qint64 cost;
+    };
+
+    void evictToBudget();
+
+    mutable QMutex mutex;
+    std::list<Node> lru;        // most recently used first
+    QHash<Key, std::list<Node>::iterator> index;
+    qint64 budget = defaultBudget;
+    ThumbnailCacheStats counters;
+};
+
+#endif // THUMBNAILCACHE_H
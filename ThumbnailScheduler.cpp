@@ -0,0 +1,120 @@
+#include "ThumbnailScheduler.h"
+#include "ThumbnailStore.h"
+#include "ThumbnailCache.h"
+
+#include <QFileInfo>
+#include <QThread>
+#include <QDebug>
+
+ThumbnailScheduler::ThumbnailScheduler(int tier, QObject* parent)
+    : QObject(parent), currentTier(ThumbnailStore::tierFor(tier)) {
+    // ✅ Leave most cores to the face scanner; decoding is mostly I/O and libjpeg anyway
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+    pool.setObjectName("ThumbnailScheduler");
+    maxInFlight = pool.maxThreadCount() * 2;  // keeps workers busy across the GUI round trip
+}
+
+ThumbnailScheduler::~ThumbnailScheduler() {
+    ++generation;
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ThumbnailScheduler::reset() {
+    ++generation;
+    queue.clear();
+    inFlight.clear();
+    pool.clear();  // not-yet-started jobs of the old folder
+}
+
+void ThumbnailScheduler::setTier(int tier) {
+    tier = ThumbnailStore::tierFor(tier);
+    if (tier == currentTier) return;
+    reset();
+    currentTier = tier;
+}
+
+QImage ThumbnailScheduler::closestCached(const ThumbnailRequest& request) const {
+    if (request.mtime == 0) return QImage();  // no cache key yet
+
+    // Largest smaller tier first (sharp enough while upscaled), else the nearest bigger one
+    const QList<int>& tiers = ThumbnailStore::tiers();
+    const int at = tiers.indexOf(currentTier);
+    for (int i = at - 1; i >= 0; --i) {
+        QImage image = ThumbnailCache::instance().find(request.path, request.mtime, tiers[i]);
+        if (!image.isNull()) return image;
+    }
+    for (int i = at + 1; i < tiers.size(); ++i) {
+        QImage image = ThumbnailCache::instance().find(request.path, request.mtime, tiers[i]);
+        if (!image.isNull()) return image;
+    }
+    return QImage();
+}
+
+void ThumbnailScheduler::setWanted(const QList<ThumbnailRequest>& requests) {
+    queue.clear();
+    for (const ThumbnailRequest& request : requests) {
+        if (inFlight.contains(request.path))
+            continue;
+
+        // ✅ Recently seen: paint now, no stat, no decode
+        QImage cached = request.mtime == 0 ? QImage()
+                                           : ThumbnailCache::instance().find(request.path, request.mtime, currentTier);
+        if (!cached.isNull()) {
+            emit thumbnailReady(request.path, cached, true);
+            continue;
+        }
+
+        // ✅ Zoomed: another tier paints now and is upgraded when this one is ready
+        QImage standIn = closestCached(request);
+        if (!standIn.isNull())
+            emit thumbnailReady(request.path, standIn, false);
+        queue.append(request);
+    }
+    pump();
+}
+
+void ThumbnailScheduler::pump() {
+    while (!queue.isEmpty() && inFlight.size() < maxInFlight) {
+        const ThumbnailRequest request = queue.takeFirst();
+        const quint64 jobGeneration = generation;
+        const int tier = currentTier;
+        inFlight.insert(request.path);
+
+        pool.start([this, request, jobGeneration, tier]() {
+            QImage image;
+            if (jobGeneration == generation) {
+                // Rows the listing has not stat'd yet are stat'd here, not held back until it gets to them
+                const QFileInfo info(request.path);
+                const qint64 mtime = request.mtime != 0 ? request.mtime : info.lastModified().toMSecsSinceEpoch();
+
+                QHash<int, QImage> generated;
+                image = ThumbnailStore::instance().thumbnail(info, tier, &generated);
+                ThumbnailCache::instance().insert(request.path, mtime, tier, image);
+
+                // Smaller tiers scaled from a fresh decode: kept in memory only
+                for (auto it = generated.constBegin(); it != generated.constEnd(); ++it) {
+                    if (it.key() < tier)
+                        ThumbnailCache::instance().insert(request.path, mtime, it.key(), it.value());
+                }
+            }
+            QMetaObject::invokeMethod(this, [this, path = request.path, jobGeneration, image]() {
+                finished(path, jobGeneration, image);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void ThumbnailScheduler::finished(const QString& path, quint64 jobGeneration, const QImage& image) {
+    if (jobGeneration != generation)
+        return;  // folder changed; reset() already forgot this job
+
+    inFlight.remove(path);
+    if (!image.isNull()) {
+        emit thumbnailReady(path, image, true);
+    } else {
+        qWarning() << "❌ Failed to generate thumbnail for:" << path;
+        emit thumbnailFailed(path);
+    }
+    pump();
+}
@@ -0,0 +1,70 @@
+#ifndef THUMBNAILSCHEDULER_H
+#define THUMBNAILSCHEDULER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QStringList>
+#include <QSet>
+#include <QImage>
+#include <atomic>
+
+// A wanted thumbnail; mtime comes from the directory listing, so a cache hit needs no stat.
+// 0 = not stat'd yet: the job stats the file itself instead of waiting for the listing.
+struct ThumbnailRequest {
+    QString path;
+    qint64 mtime = 0;
+};
+
+// Bounded thumbnail executor for the folder view. Owns a small thread pool,
+// so thumbnails never compete with face scanning on the global pool.
+//
+// The view tells it which paths it wants right now (on screen first, then a
+// screen of lookahead) and the queue is replaced wholesale: items that
+// scrolled away are dropped before they start. reset() starts a new
+// generation when the folder changes; jobs of older generations skip the
+// decode if they have not started and their results are discarded.
+//
+// Thumbnails are made at one tier (ThumbnailStore::tiers) at a time. Keys
+// are absolute file paths. Thumbnails in ThumbnailCache are handed out
+// straight away, without touching the disk or the pool; on a miss the
+// closest cached tier is handed out as a stand-in (exact = false) until the
+// real one is ready. Called from the GUI thread only; thumbnailReady is
+// emitted there too.
+class ThumbnailScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailScheduler(int tier, QObject* parent = nullptr);
+    ~ThumbnailScheduler();
+
+    // Drops everything queued and ignores results still in flight
+    void reset();
+
+    // Zoom changed: resets, later requests are made at `tier`
+    void setTier(int tier);
+    int tier() const { return currentTier; }
+
+    // Replaces the queue, highest priority first; paths already in flight are not requeued
+    void setWanted(const QList<ThumbnailRequest>& requests);
+
+    int pending() const { return queue.size() + inFlight.size(); }
+
+signals:
+    void thumbnailReady(const QString& path, const QImage& image, bool exact);
+    void thumbnailFailed(const QString& path);
+
+private:
+    void pump();
+    void finished(const QString& path, quint64 generation, const QImage& image);
+
+    QImage closestCached(const ThumbnailRequest& request) const;
+
+    int currentTier;
+    QThreadPool pool;
+    int maxInFlight = 4;
+    std::atomic<quint64> generation { 0 };
+    QList<ThumbnailRequest> queue;
+    QSet<QString> inFlight;
+};
+
+#endif // THUMBNAILSCHEDULER_H
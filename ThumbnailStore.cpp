@@ -0,0 +1,425 @@
+#include "ThumbnailStore.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QRandomGenerator>
+#include <QDateTime>
+#include <QBuffer>
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QDir>
+#include <QtEndian>
+#include <QDebug>
+
+static const char PACK_MAGIC[8] = { 'P', 'X', 'T', 'P', 'A', 'C', 'K', '1' };
+static const char INDEX_MAGIC[8] = { 'P', 'X', 'T', 'I', 'D', 'X', '1', '\0' };
+constexpr quint32 ENTRY_MAGIC = 0x31455450;        // "PTE1"
+constexpr qint64 PACK_HEADER = 16;
+constexpr qint64 ENTRY_FIXED = 4 + 2 + 8 + 8 + 8 + 4;
+constexpr qint64 COMPACT_MIN_BYTES = 1 << 20;
+
+template <typename T>
+static void putLE(QByteArray& out, T value) {
+    uchar buf[sizeof(T)];
+    qToLittleEndian<T>(value, buf);
+    out.append(reinterpret_cast<const char*>(buf), sizeof(T));
+}
+
+static void appendEntry(QByteArray& out, const QString& name, qint64 mtime, qint64 size,
+                        qint64 offset, quint32 length) {
+    QByteArray utf8 = name.toUtf8();
+    putLE<quint32>(out, ENTRY_MAGIC);
+    putLE<quint16>(out, static_cast<quint16>(utf8.size()));
+    out.append(utf8);
+    putLE<qint64>(out, mtime);
+    putLE<qint64>(out, size);
+    putLE<qint64>(out, offset);
+    putLE<quint32>(out, length);
+}
+
+static QByteArray packHeader(quint64 generation) {
+    QByteArray header(PACK_MAGIC, sizeof(PACK_MAGIC));
+    putLE<quint64>(header, generation);
+    return header;
+}
+
+static QByteArray indexHeader(quint64 generation, const QString& folder) {
+    QByteArray header(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    QByteArray utf8 = folder.toUtf8();
+    putLE<quint64>(header, generation);
+    putLE<quint16>(header, static_cast<quint16>(utf8.size()));
+    header.append(utf8);
+    return header;
+}
+
+// ==== ThumbnailPack ====
+
+ThumbnailPack::ThumbnailPack(const QString& folder, const QString& basePath) : folder(folder) {
+    QString key = QCryptographicHash::hash(folder.toUtf8(), QCryptographicHash::Sha1).toHex();
+    dataPath = basePath + "/" + key + ".pack";
+    indexPath = basePath + "/" + key + ".idx";
+}
+
+bool ThumbnailPack::ensureOpen() {
+    if (!opened) {
+        opened = true;
+        valid = open();
+        if (!valid)
+            qWarning() << "❌ Thumbnail pack unavailable for" << folder;
+    }
+    return valid;
+}
+
+ThumbnailPack::~ThumbnailPack() {
+    QMutexLocker locker(&mutex);
+    unmap();
+    data.close();
+    index.close();
+}
+
+void ThumbnailPack::unmap() {
+    if (mapped)
+        data.unmap(mapped);
+    mapped = nullptr;
+    mappedSize = 0;
+}
+
+bool ThumbnailPack::open() {
+    data.setFileName(dataPath);
+    index.setFileName(indexPath);
+    if (!data.open(QIODevice::ReadWrite) || !index.open(QIODevice::ReadWrite)) {
+        qWarning() << "❌ Cannot open thumbnail pack:" << dataPath << data.errorString() << index.errorString();
+        return false;
+    }
+
+    quint64 generation = 0;
+    bool usable = false;
+    if (data.size() >= PACK_HEADER) {
+        QByteArray header = data.read(PACK_HEADER);
+        if (header.startsWith(QByteArray(PACK_MAGIC, sizeof(PACK_MAGIC)))) {
+            generation = qFromLittleEndian<quint64>(header.constData() + sizeof(PACK_MAGIC));
+            usable = loadIndex(generation);
+        }
+    }
+
+    if (!usable) {
+        if (!createFiles()) return false;
+    } else {
+        // ✅ Mostly superseded thumbnails (photos edited, re-saved): rewrite before mapping
+        qint64 payload = data.size() - PACK_HEADER;
+        bool sparse = payload > COMPACT_MIN_BYTES && payload > 2 * liveBytes;
+        bool bloatedIndex = indexEntries > 2 * entries.size() + 1024;
+        if ((sparse || bloatedIndex) && !compact())
+            qWarning() << "⚠️ Thumbnail pack compaction failed, keeping it as is:" << dataPath;
+    }
+
+    if (data.size() > PACK_HEADER) {
+        mappedSize = data.size();
+        mapped = data.map(0, mappedSize);
+        if (!mapped)
+            mappedSize = 0;  // reads fall back to the file handle
+    }
+    return true;
+}
+
+bool ThumbnailPack::loadIndex(quint64 generation) {
+    // ✅ The whole index in one read; a 5k-image folder is a few hundred KB
+    index.seek(0);
+    const QByteArray bytes = index.readAll();
+    const char* p = bytes.constData();
+    const qint64 n = bytes.size();
+
+    if (n < qint64(sizeof(INDEX_MAGIC)) + 10 || !bytes.startsWith(QByteArray(INDEX_MAGIC, sizeof(INDEX_MAGIC))))
+        return false;
+    if (qFromLittleEndian<quint64>(p + 8) != generation)
+        return false;
+    qint64 pos = 18 + qFromLittleEndian<quint16>(p + 16);
+    if (pos > n || QString::fromUtf8(p + 18, pos - 18) != folder)
+        return false;
+
+    const qint64 dataSize = data.size();
+    entries.clear();
+    liveBytes = 0;
+    indexEntries = 0;
+    while (pos + ENTRY_FIXED <= n && qFromLittleEndian<quint32>(p + pos) == ENTRY_MAGIC) {
+        qint64 nameLen = qFromLittleEndian<quint16>(p + pos + 4);
+        if (pos + ENTRY_FIXED + nameLen > n) break;  // torn tail
+
+        const char* q = p + pos + 6;
+        QString name = QString::fromUtf8(q, nameLen);
+        q += nameLen;
+
+        Entry e;
+        e.mtime = qFromLittleEndian<qint64>(q);
+        e.size = qFromLittleEndian<qint64>(q + 8);
+        e.offset = qFromLittleEndian<qint64>(q + 16);
+        e.length = qFromLittleEndian<quint32>(q + 24);
+        pos += ENTRY_FIXED + nameLen;
+        ++indexEntries;
+
+        if (e.offset < PACK_HEADER || e.offset + e.length > dataSize)
+            continue;  // bytes never reached the pack
+        if (!name.contains('/'))
+            continue;  // untiered thumbnail from before tiers: dropped at the next compaction
+        auto it = entries.constFind(name);
+        if (it != entries.constEnd())
+            liveBytes -= it->length;
+        entries.insert(name, e);
+        liveBytes += e.length;
+    }
+
+    // Drop a torn tail so later appends start on an entry boundary
+    if (pos < n && !index.resize(pos))
+        return false;
+    return true;
+}
+
+bool ThumbnailPack::createFiles() {
+    quint64 generation = QRandomGenerator::global()->generate64();
+    QByteArray dataHeader = packHeader(generation);
+    QByteArray idxHeader = indexHeader(generation, folder);
+
+    entries.clear();
+    liveBytes = 0;
+    indexEntries = 0;
+    return data.resize(0) && data.seek(0) && data.write(dataHeader) == dataHeader.size() && data.flush()
+           && index.resize(0) && index.seek(0) && index.write(idxHeader) == idxHeader.size() && index.flush();
+}
+
+bool ThumbnailPack::compact() {
+    quint64 generation = QRandomGenerator::global()->generate64();
+    QFile newData(dataPath + ".tmp");
+    QFile newIndex(indexPath + ".tmp");
+    if (!newData.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || !newIndex.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QByteArray idxBytes = indexHeader(generation, folder);
+    newData.write(packHeader(generation));
+
+    QHash<QString, Entry> kept;
+    qint64 offset = PACK_HEADER;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        Entry e = it.value();
+        if (!data.seek(e.offset)) return false;
+        QByteArray bytes = data.read(e.length);
+        if (bytes.size() != qint64(e.length) || newData.write(bytes) != bytes.size())
+            return false;
+
+        e.offset = offset;
+        offset += e.length;
+        appendEntry(idxBytes, it.key(), e.mtime, e.size, e.offset, e.length);
+        kept.insert(it.key(), e);
+    }
+    if (newIndex.write(idxBytes) != idxBytes.size() || !newData.flush() || !newIndex.flush())
+        return false;
+    newData.close();
+    newIndex.close();
+
+    // Pack first: an index left behind from the old generation no longer matches and is dropped
+    data.close();
+    index.close();
+    bool swapped = QFile::remove(dataPath) && QFile::rename(newData.fileName(), dataPath)
+                   && QFile::remove(indexPath) && QFile::rename(newIndex.fileName(), indexPath);
+    if (!data.open(QIODevice::ReadWrite) || !index.open(QIODevice::ReadWrite))
+        return false;
+    if (!swapped)
+        return loadIndex(generation) || createFiles();
+
+    qint64 before = liveBytes;
+    entries = kept;
+    indexEntries = kept.size();
+    qDebug() << "🧹 Compacted thumbnail pack for" << folder << ":" << kept.size() << "thumbnails," << before / 1024 << "KB";
+    return true;
+}
+
+QByteArray ThumbnailPack::find(const QString& key, qint64 mtime, qint64 size) {
+    QMutexLocker locker(&mutex);
+    if (!ensureOpen()) return QByteArray();
+
+    auto it = entries.constFind(key);
+    if (it == entries.constEnd() || it->mtime != mtime || it->size != size)
+        return QByteArray();  // missing, or the photo changed since it was made
+    const Entry e = it.value();
+
+    // The mapping never moves while the pack is open, so mapped reads need no lock
+    if (e.offset + e.length <= mappedSize) {
+        locker.unlock();
+        return QByteArray(reinterpret_cast<const char*>(mapped + e.offset), e.length);
+    }
+
+    // Appended since the pack was opened
+    if (!data.seek(e.offset)) return QByteArray();
+    QByteArray bytes = data.read(e.length);
+    return bytes.size() == qint64(e.length) ? bytes : QByteArray();
+}
+
+bool ThumbnailPack::store(const QString& key, qint64 mtime, qint64 size, const QByteArray& encoded) {
+    if (encoded.isEmpty()) return false;
+
+    QMutexLocker locker(&mutex);
+    if (!ensureOpen()) return false;
+
+    const qint64 offset = data.size();
+    if (!data.seek(offset) || data.write(encoded) != encoded.size() || !data.flush()) {
+        qWarning() << "❌ Thumbnail pack append failed:" << dataPath << data.errorString();
+        data.resize(offset);
+        return false;
+    }
+
+    QByteArray record;
+    appendEntry(record, key, mtime, size, offset, static_cast<quint32>(encoded.size()));
+    const qint64 indexEnd = index.size();
+    if (!index.seek(indexEnd) || index.write(record) != record.size() || !index.flush()) {
+        qWarning() << "❌ Thumbnail index append failed:" << indexPath << index.errorString();
+        index.resize(indexEnd);
+        return false;
+    }
+
+    auto it = entries.constFind(key);
+    if (it != entries.constEnd())
+        liveBytes -= it->length;
+    entries.insert(key, { mtime, size, offset, static_cast<quint32>(encoded.size()) });
+    liveBytes += encoded.size();
+    ++indexEntries;
+    return true;
+}
+
+// ==== ThumbnailStore ====
+
+ThumbnailStore& ThumbnailStore::instance() {
+    static ThumbnailStore inst;
+    return inst;
+}
+
+ThumbnailStore::ThumbnailStore() {
+    basePath = QCoreApplication::applicationDirPath() + "/.cache/thumbpacks";
+    if (!QDir().mkpath(basePath))
+        qWarning() << "❌ Failed to create thumbnail cache folder:" << basePath;
+}
+
+std::shared_ptr<ThumbnailPack> ThumbnailStore::packFor(const QString& folder) {
+    QMutexLocker locker(&mutex);
+
+    auto it = packs.constFind(folder);
+    if (it != packs.constEnd()) {
+        recent.removeOne(folder);
+        recent.append(folder);
+        return it.value();
+    }
+
+    // An evicted pack another thread still uses is taken back, never opened a second time
+    std::shared_ptr<ThumbnailPack> pack = live.value(folder).lock();
+    if (!pack) {
+        pack = std::make_shared<ThumbnailPack>(folder, basePath);  // cheap: files open on first use
+        live.insert(folder, pack);
+    }
+    packs.insert(folder, pack);
+    recent.append(folder);
+
+    // Evicted packs close once the last thread using them lets go
+    if (recent.size() > maxOpenPacks) {
+        while (recent.size() > maxOpenPacks)
+            packs.remove(recent.takeFirst());
+        for (auto w = live.begin(); w != live.end();) {
+            if (w.value().expired())
+                w = live.erase(w);
+            else
+                ++w;
+        }
+    }
+    return pack;
+}
+
+const QList<int>& ThumbnailStore::tiers() {
+    static const QList<int> edges { 64, 128, 256, 512 };
+    return edges;
+}
+
+int ThumbnailStore::tierFor(int edge) {
+    for (int tier : tiers()) {
+        if (tier >= edge)
+            return tier;
+    }
+    return tiers().last();
+}
+
+QString ThumbnailStore::tierKey(const QFileInfo& info, int tier) {
+    // '/' never occurs in a file name, so keys cannot collide
+    return QString::number(tier) + '/' + info.fileName();
+}
+
+QImage ThumbnailStore::find(const QFileInfo& info, int tier) {
+    std::shared_ptr<ThumbnailPack> pack = packFor(info.absolutePath());
+    QByteArray bytes = pack->find(tierKey(info, tier), info.lastModified().toMSecsSinceEpoch(), info.size());
+    if (bytes.isEmpty()) return QImage();
+    return QImage::fromData(bytes, "JPG");  // null if the bytes never made it to disk: regenerated
+}
+
+bool ThumbnailStore::store(const QFileInfo& info, int tier, const QImage& thumb) {
+    if (thumb.isNull()) return false;
+
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    if (!thumb.save(&buffer, "JPG")) return false;
+
+    std::shared_ptr<ThumbnailPack> pack = packFor(info.absolutePath());
+    return pack->store(tierKey(info, tier), info.lastModified().toMSecsSinceEpoch(), info.size(), encoded);
+}
+
+QImage ThumbnailStore::thumbnail(const QFileInfo& info, int tier, QHash<int, QImage>* generated) {
+    tier = tierFor(tier);
+    QImage cached = find(info, tier);
+    if (!cached.isNull())
+        return cached;
+
+    // ✅ Decoded no larger than asked for, and only this tier is encoded and stored
+    QString error;
+    QImage wanted = decodeScaled(info.absoluteFilePath(), QSize(tier, tier), &error);
+    if (wanted.isNull()) {
+        qWarning() << "❌ Failed to load image:" << info.absoluteFilePath() << "| Error:" << error;
+        return QImage();
+    }
+    if (!store(info, tier, wanted))
+        qWarning() << "❌ Failed to store" << tier << "px thumbnail for:" << info.absoluteFilePath();
+
+    // Smaller tiers come almost free from this one; callers may keep them in memory
+    if (generated) {
+        generated->insert(tier, wanted);
+        QImage source = wanted;
+        for (int i = tiers().indexOf(tier) - 1; i >= 0; --i) {
+            const int edge = tiers()[i];
+            source = source.width() <= edge && source.height() <= edge
+                         ? source
+                         : source.scaled(edge, edge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            generated->insert(edge, source);
+        }
+    }
+    return wanted;
+}
+
+QImage ThumbnailStore::decodeScaled(const QString& imagePath, const QSize& box, QString* error) {
+    QImageReader reader(imagePath);
+    reader.setAutoTransform(true);
+
+    // The scaled size applies to the stored pixels, before the EXIF rotation
+    const QSize stored = reader.size();
+    if (stored.isValid()) {
+        bool rotated = reader.transformation().testFlag(QImageIOHandler::TransformationRotate90);
+        QSize target = stored.scaled(rotated ? box.transposed() : box, Qt::KeepAspectRatio);
+        if (target.width() < stored.width() && target.height() < stored.height()) {
+            // 2x headroom keeps the final smooth scale sharp
+            reader.setScaledSize((target * 2).boundedTo(stored));
+        }
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        if (error) *error = reader.errorString();
+        return QImage();
+    }
+    if (image.width() <= box.width() && image.height() <= box.height())
+        return image;
+    return image.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
@@ -0,0 +1,121 @@
+#ifndef THUMBNAILSTORE_H
+#define THUMBNAILSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QHash>
+#include <QImage>
+#include <QByteArray>
+#include <QSize>
+#include <memory>
+
+// Thumbnails of one source folder: <name>.pack holds the encoded images,
+// <name>.idx says where each one is and which version of the source it shows.
+// Entries are keyed "<tier>/<file name>", one per thumbnail tier.
+//
+//   .pack   [magic 8][generation u64] then JPEG bytes, append-only, memory-mapped
+//   .idx    [magic 8][generation u64][folder len u16][folder utf8]
+//           then entries [u32 magic][u16 name len][name][i64 mtime][i64 size][i64 offset][u32 length]
+//
+// Both files are only ever appended to; the last entry for a key wins.
+// Bytes are written before their index entry, so a torn tail entry after a
+// crash is dropped on load, and an entry whose bytes never reached the disk
+// just fails to decode and is regenerated. When superseded entries make up
+// most of the pack it is rewritten on open, under a new generation; an index
+// that does not match its pack's generation is discarded.
+//
+// The files are opened (and compacted) on first use, under the pack's own
+// lock, so creating a pack is cheap and never blocks other folders.
+class ThumbnailPack {
+public:
+    ThumbnailPack(const QString& folder, const QString& basePath);
+    ~ThumbnailPack();
+
+    // Encoded thumbnail stored under `key` for exactly this mtime/size; empty otherwise
+    QByteArray find(const QString& key, qint64 mtime, qint64 size);
+
+    bool store(const QString& key, qint64 mtime, qint64 size, const QByteArray& encoded);
+
+private:
+    struct Entry {
+        qint64 mtime = 0;
+        qint64 size = 0;
+        qint64 offset = 0;
+        quint32 length = 0;
+    };
+
+    bool ensureOpen();
+    bool open();
+    bool loadIndex(quint64 generation);
+    bool createFiles();
+    bool compact();
+    void unmap();
+
+    QString folder;
+    QString dataPath;
+    QString indexPath;
+    QFile data;
+    QFile index;
+    uchar* mapped = nullptr;     // [0, mappedSize) of the pack, fixed while open
+    qint64 mappedSize = 0;
+    QHash<QString, Entry> entries;
+    qint64 indexEntries = 0;     // entries in the index file, superseded ones included
+    qint64 liveBytes = 0;
+    bool opened = false;
+    bool valid = false;
+    QMutex mutex;
+};
+
+// Per-folder thumbnail packs under <app>/.cache/thumbpacks, replacing one
+// .thumb file per image. An image gets a thumbnail per tier (edge length of
+// the bounding square) as each tier is first asked for; a miss decodes only
+// as large as the requested tier. Safe to call from any
+// thread; a few recently used packs stay open, and a folder never has more
+// than one live pack, even while an evicted one is still in use.
+class ThumbnailStore {
+public:
+    static ThumbnailStore& instance();
+
+    // Tier edges, smallest first
+    static const QList<int>& tiers();
+
+    // Smallest tier that covers `edge` without upscaling; the largest tier past it
+    static int tierFor(int edge);
+
+    // Stored thumbnail if it still matches the file's mtime and size, else a null image
+    QImage find(const QFileInfo& info, int tier);
+
+    // Encodes (JPEG) and appends; the previous thumbnail of the file at this tier becomes garbage
+    bool store(const QFileInfo& info, int tier, const QImage& thumb);
+
+    // Stored thumbnail, or a fresh one: one decode at the requested tier,
+    // stored for next time. `generated` receives it plus the smaller tiers
+    // scaled from it, for memory caches; those are not written to the pack
+    // until asked for themselves. Nothing on a stored hit. QImage only: safe
+    // on worker threads, convert to QPixmap on the GUI thread.
+    QImage thumbnail(const QFileInfo& info, int tier, QHash<int, QImage>* generated = nullptr);
+
+    // Decodes straight to about twice `box` (JPEG: DCT scaling in libjpeg, so
+    // the full-resolution image is never built), then smooth-scales into `box`.
+    // EXIF orientation is applied.
+    static QImage decodeScaled(const QString& imagePath, const QSize& box, QString* error = nullptr);
+
+private:
+    ThumbnailStore();
+
+    std::shared_ptr<ThumbnailPack> packFor(const QString& folder);
+    static QString tierKey(const QFileInfo& info, int tier);
+
+    static constexpr int maxOpenPacks = 16;
+
+    QString basePath;
+    QMutex mutex;
+    QHash<QString, std::shared_ptr<ThumbnailPack>> packs;   // kept open, most recent `maxOpenPacks`
+    QHash<QString, std::weak_ptr<ThumbnailPack>> live;      // every pack some thread still holds
+    QStringList recent;          // most recently used last
+};
+
+#endif // THUMBNAILSTORE_H
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <numeric>
 #include <opencv2/core.hpp>
+#include "FaceTypes.h"
 
 inline float l2Distance(const std::vector<float>& a, const std::vector<float>& b) {
     if (a.size() != b.size()) return 1e6f;
@@ -13,6 +14,20 @@ inline float l2Distance(const std::vector<float>& a, const std::vector<float>& b
                                         [](float x, float y) { return (x - y) * (x - y); }));
 }
 
+inline float l2Distance(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return std::sqrt(sum);
+}
+
+inline float l2Distance(const std::vector<float>& a, const EmbeddingView& b) {
+    if (a.size() != b.size) return 1e6f;
+    return l2Distance(a.data(), b.data, b.size);
+}
+
 inline float cosineSimilarity(const std::vector<float>& a, const std::vector<float>& b) {
     if (a.size() != b.size()) return 0.0f;
     float dot = std::inner_product(a.begin(), a.end(), b.begin(), 0.0f);
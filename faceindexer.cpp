@@ -18,6 +18,14 @@ QList<FaceEntry> FaceIndexer::getFaceEntriesInFolder(const QString& folderPath)
     return FaceDatabaseManager::instance().getFacesForFolder(folderPath);
 }
 
+bool FaceIndexer::streamFaceEntries(const QString& folderPath, bool recursive,
+                                    const FaceChunkCallback& onChunk, int chunkSize)
+{
+    return recursive
+               ? FaceDatabaseManager::instance().streamFaceEntriesInSubtree(folderPath, onChunk, chunkSize)
+               : FaceDatabaseManager::instance().streamFaceEntriesInFolder(folderPath, onChunk, chunkSize);
+}
+
 QList<FaceEntry> FaceIndexer::getFaceEntriesByGlobalId(const QString& globalId)
 {
     return FaceDatabaseManager::instance().getFacesByGlobalId(globalId);
@@ -18,6 +18,10 @@ public:
     // Fetch all face entries under a given folder path (recursively)
     QList<FaceEntry> getFaceEntriesInFolder(const QString& folderPath);
 
+    // Stream face entries (with embeddings) chunk by chunk instead of materializing the list
+    bool streamFaceEntries(const QString& folderPath, bool recursive,
+                           const FaceChunkCallback& onChunk, int chunkSize = 512);
+
     // Retrieve face entries by shared global ID
     QList<FaceEntry> getFaceEntriesByGlobalId(const QString& globalId);
 
@@ -26,6 +26,10 @@
 #include <QMessageBox>
 #include <QDesktopServices>
 #include <QCoreApplication>
+#include <QSet>
+#include <QHash>
+#include <QScrollBar>
+#include <QSlider>
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -34,6 +38,16 @@
 #include "faceindexer.h"
 #include "FaceListItemDelegate.h"
 #include "FaceDatabaseManager.h"
+#include "FaceWriteQueue.h"
+#include "FaceCropStore.h"
+#include "ThumbnailScheduler.h"
+#include "ThumbnailStore.h"
+#include "FolderModel.h"
+#include "ImageViewer.h"
+#include "DirectoryCache.h"
+#include "Prefetcher.h"
+#include "ScanPipeline.h"
+#include "EmbeddingStore.h"
 #include "embeddingUtils.h"
 
 FaceIndexer faceIndexer;
@@ -44,64 +58,6 @@ constexpr double matchDIST = 0.5f;
 constexpr double goodFocusThreshold = 100.0; // e.g. ideal Laplacian variance
 constexpr double focusTolerance = 25.0;      // how far below is still acceptable
 
-enum class ResizeMode {
-    Original,
-    Fit1024x1024,
-    Fit1280x720
-};
-
-cv::Mat resizeImageForDetection(const cv::Mat& input, ResizeMode mode,
-                                cv::Size& newSize, double& scaleX, double& scaleY) {
-    if (mode == ResizeMode::Original) {
-        newSize = input.size();
-        scaleX = 1.0;
-        scaleY = 1.0;
-        return input.clone();
-    }
-
-    int maxWidth, maxHeight;
-    if (mode == ResizeMode::Fit1024x1024) {
-        maxWidth = 1024;
-        maxHeight = 1024;
-    } else { // Fit1280x720
-        maxWidth = 1280;
-        maxHeight = 720;
-    }
-
-    int originalWidth = input.cols;
-    int originalHeight = input.rows;
-
-    double scale = std::min((double)maxWidth / originalWidth, (double)maxHeight / originalHeight);
-
-    int resizedWidth = static_cast<int>(originalWidth * scale);
-    int resizedHeight = static_cast<int>(originalHeight * scale);
-
-    cv::Mat resized;
-    cv::resize(input, resized, cv::Size(resizedWidth, resizedHeight), 0, 0, cv::INTER_AREA);
-
-    scaleX = (double)originalWidth / resizedWidth;
-    scaleY = (double)originalHeight / resizedHeight;
-    newSize = cv::Size(resizedWidth, resizedHeight);
-
-    return resized;
-}
-
-QString virtualCachePath(const QString& actualPath) {
-    QString base = QCoreApplication::applicationDirPath() + "/.cache";
-    QString relative = actualPath;
-
-#ifdef Q_OS_WIN
-    if (relative.length() >= 2 && relative[1] == ':') {
-        QString driveLetter = relative.left(1);
-        relative.remove(0, 2);  // remove "D:"
-        relative = driveLetter + "_/" + relative;
-    }
-#endif
-
-    relative = QDir::cleanPath(relative);  // ✅ normalize "//" or "../"
-    return base + "/" + relative;
-}
-
 std::vector<float> normalizeEmbedding(const std::vector<float>& emb) {
     float norm = std::sqrt(std::inner_product(emb.begin(), emb.end(), emb.begin(), 0.0f));
     std::vector<float> result(emb.size());
@@ -147,34 +103,6 @@ cv::Mat resizeToFit1280x720(const cv::Mat& input, cv::Size& newSize, double& sca
     return resized;
 }
 
-bool eyesAreOpen(const dlib::full_object_detection& shape) {
-    auto eyeOpenness = [&](int top1, int top2, int bottom1, int bottom2) {
-        return (shape.part(bottom1).y() + shape.part(bottom2).y()) -
-               (shape.part(top1).y() + shape.part(top2).y());
-    };
-
-    double leftEye = eyeOpenness(37, 38, 41, 40);  // left eye
-    double rightEye = eyeOpenness(43, 44, 47, 46); // right eye
-
-    double eyeOpenScore = (leftEye + rightEye) / 2.0;
-    return eyeOpenScore > 4.0;  // adjust threshold if needed
-}
-
-double getSymmetryScore(const dlib::full_object_detection& shape) {
-    double eyeCenter = (shape.part(36).x() + shape.part(45).x()) / 2.0;
-    double noseX = shape.part(30).x();
-    return std::abs(eyeCenter - noseX);  // smaller = more frontal
-}
-
-double getFocusScore(const cv::Mat& faceMat) {
-    cv::Mat gray, lap;
-    cv::cvtColor(faceMat, gray, cv::COLOR_BGR2GRAY);
-    cv::Laplacian(gray, lap, CV_64F);
-    cv::Scalar mean, stddev;
-    cv::meanStdDev(lap, mean, stddev);
-    return stddev[0] * stddev[0];  // variance = sharpness
-}
-
 struct FaceStats {
     std::vector<float> embedding;
     double symmetry;
@@ -182,69 +110,13 @@ struct FaceStats {
     QPixmap thumb;
     QString imagePath;
     int count = 1;  // how many images this person matched
+    QString globalId;  // set when loaded from the index
 };
 
 
 std::vector<FaceStats> personList;
 
 
-QPixmap getCachedThumbnail(const QString &imagePath, QSize size) {
-    QFileInfo info(imagePath);
-    if (!info.exists()) {
-        qWarning() << "❌ Input file does not exist:" << imagePath;
-        return QPixmap();
-    }
-
-    QString cachePath = virtualCachePath(info.absolutePath()) + "/thumbnails";
-    QString thumbPath = QDir(cachePath).absoluteFilePath(info.fileName() + ".thumb");
-
-    qDebug() << "🔍 Thumbnail request for:" << imagePath;
-    qDebug() << "📁 Cache folder:" << cachePath;
-    qDebug() << "📄 Thumbnail file:" << thumbPath;
-
-    // ✅ Ensure cache folder is created in thread-safe way
-    static QMutex cacheMutex;
-    {
-        QMutexLocker locker(&cacheMutex);
-        QDir dir(cachePath);
-        if (!dir.exists()) {
-            bool created = dir.mkpath(".");
-            qDebug() << (created ? "✅ Cache folder created:" : "❌ Failed to create cache folder:") << cachePath;
-        }
-    }
-
-    // ✅ Load existing thumbnail if available
-    if (QFile::exists(thumbPath)) {
-        QPixmap cached(thumbPath);
-        if (!cached.isNull()) {
-            qDebug() << "📦 Loaded cached thumbnail from:" << thumbPath;
-            return cached;
-        } else {
-            qWarning() << "⚠️ Cached .thumb exists but failed to load:" << thumbPath;
-        }
-    }
-
-    // ✅ Load original image with EXIF rotation
-    QImageReader reader(imagePath);
-    reader.setAutoTransform(true);
-    QImage image = reader.read();
-    if (image.isNull()) {
-        qWarning() << "❌ Failed to load image:" << imagePath << "| Error:" << reader.errorString();
-        return QPixmap();
-    }
-
-    QPixmap thumb = QPixmap::fromImage(image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-    bool saved = thumb.save(thumbPath, "JPG");
-
-    if (!saved) {
-        qWarning() << "❌ Failed to save thumbnail to:" << thumbPath;
-    } else {
-        qDebug() << "💾 Saved new thumbnail to:" << thumbPath;
-    }
-
-    return thumb;
-}
-
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setWindowTitle("Photo Explorer");
     resize(1200, 800);
@@ -268,12 +140,22 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     QCheckBox *includeSubfoldersCheckbox = new QCheckBox("Include Subfolders");
     pathLabel = new QLabel("This PC");
 
+    // Thumbnail zoom: any edge between the smallest and the largest tier
+    QSlider *zoomSlider = new QSlider(Qt::Horizontal);
+    zoomSlider->setRange(ThumbnailStore::tiers().first(), ThumbnailStore::tiers().last());
+    zoomSlider->setSingleStep(16);
+    zoomSlider->setPageStep(64);
+    zoomSlider->setValue(folderIconEdge);
+    zoomSlider->setFixedWidth(120);
+    zoomSlider->setToolTip("Thumbnail size");
+
     // Add to layout
     toolbarLayout->addWidget(backButton);
     toolbarLayout->addWidget(homeButton);
     toolbarLayout->addWidget(pathLabel);
     toolbarLayout->addWidget(showHiddenFoldersCheckbox);
     toolbarLayout->addStretch();
+    toolbarLayout->addWidget(zoomSlider);
     toolbarLayout->addWidget(createFolderButton);
     toolbarLayout->addWidget(copyButton);
     toolbarLayout->addWidget(pasteButton);
@@ -314,19 +196,42 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     stack->addWidget(driveList);
 
     // === Folder View (Right side thumbnails) ===
-    folderView = new QListWidget(this);
+    folderModel = new FolderModel(this);
+    folderView = new QListView(this);
+    folderView->setModel(folderModel);
+    folderView->setUniformItemSizes(true);  // layout without asking every row for its size
     folderView->setViewMode(QListView::IconMode);
-    folderView->setIconSize(QSize(128, 128));
-    folderView->setGridSize(QSize(140, 172));
+    folderView->setIconSize(QSize(folderIconEdge, folderIconEdge));
+    folderView->setGridSize(QSize(folderIconEdge + 12, folderIconEdge + 44));
     folderView->setSpacing(0);
     folderView->setResizeMode(QListView::Adjust);
     folderView->setMovement(QListView::Static);
     folderView->setSelectionMode(QAbstractItemView::ExtendedSelection);
     folderView->setFocus();
-    folderView->setItemDelegate(new FaceListItemDelegate(FaceListItemDelegate::FolderViewMode, this));
+    folderDelegate = new FaceListItemDelegate(FaceListItemDelegate::FolderViewMode, this);
+    folderView->setItemDelegate(folderDelegate);
     folderView->setContextMenuPolicy(Qt::CustomContextMenu);
     stack->addWidget(folderView);
 
+    // ✅ Thumbnails: bounded pool, fed with what the viewport shows
+    thumbnailScheduler = new ThumbnailScheduler(folderIconEdge, this);
+    connect(thumbnailScheduler, &ThumbnailScheduler::thumbnailReady, folderModel, &FolderModel::setThumbnail);
+    connect(thumbnailScheduler, &ThumbnailScheduler::thumbnailFailed, folderModel, &FolderModel::setThumbnailFailed);
+
+    thumbnailViewportTimer = new QTimer(this);
+    thumbnailViewportTimer->setSingleShot(true);
+    thumbnailViewportTimer->setInterval(40);  // coalesce scroll bursts
+    connect(thumbnailViewportTimer, &QTimer::timeout, this, &MainWindow::requestVisibleThumbnails);
+    connect(folderView->verticalScrollBar(), &QScrollBar::valueChanged,
+            thumbnailViewportTimer, qOverload<>(&QTimer::start));
+    connect(folderView->verticalScrollBar(), &QScrollBar::rangeChanged,
+            thumbnailViewportTimer, qOverload<>(&QTimer::start));  // relayout after resize or new items
+    connect(folderModel, &FolderModel::entriesUpdated, thumbnailViewportTimer, qOverload<>(&QTimer::start));
+
+    // ✅ Idle-time warming of the likely next folders; yields as soon as anything else runs
+    prefetcher = new Prefetcher(folderIconEdge, this);
+    prefetcher->setForegroundCheck([this]() { return thumbnailScheduler->pending() > 0; });
+
     // ==== Connect UI Logic ====
 
     // Toolbar buttons
@@ -337,6 +242,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     connect(pasteButton, &QPushButton::clicked, this, &MainWindow::performPaste);
 
     connect(createFolderButton, &QPushButton::clicked, this, &MainWindow::createNewFolder);
+    connect(zoomSlider, &QSlider::valueChanged, this, &MainWindow::setFolderZoom);
 
     connect(includeSubfoldersCheckbox, &QCheckBox::toggled, this, [this](bool checked) {
         includeSubfolders = checked;
@@ -355,36 +261,80 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     });
 
     // Folder view double click → open folder or image
-    connect(folderView, &QListWidget::itemDoubleClicked, this, [this](QListWidgetItem* item) {
-        QString path = item->data(Qt::UserRole).toString();
-        QFileInfo info(path);
-        if (info.isDir()) {
-            navigateTo(info.absoluteFilePath());
-        } else if (info.isFile()) {
+    connect(folderView, &QListView::doubleClicked, this, [this](const QModelIndex& index) {
+        QString path = index.data(FolderModel::PathRole).toString();
+        if (index.data(FolderModel::IsDirRole).toBool()) {
+            navigateTo(path);
+        } else {
             showImagePopup(path);
         }
     });
 
-    connect(folderView, &QListWidget::customContextMenuRequested,
+    connect(folderView, &QListView::customContextMenuRequested,
             this, &MainWindow::showFolderViewContextMenu);
 
     // Face list → update checkboxes in folder view
     connect(faceList, &QListWidget::itemChanged,
             this, &MainWindow::updateFolderViewCheckboxesFromFaceSelection);
 
+    // ==== Background index maintenance ====
+    indexSweeper = new IndexSweeper(this);
+    connect(indexSweeper, &IndexSweeper::finished, this, [this](const SweepReport& report) {
+        if (report.pathsPurged > 0 || report.vacuumed) {
+            statusBar()->showMessage(QString("🧹 Index cleanup: removed %1 missing file(s), %2 face(s), reclaimed %3 KB")
+                                         .arg(report.pathsPurged).arg(report.facesPurged)
+                                         .arg(report.bytesReclaimed / 1024), 4000);
+        } else if (!report.unavailableRoots.isEmpty()) {
+            statusBar()->showMessage(QString("⚠️ Index cleanup skipped %1 unavailable folder(s): %2")
+                                         .arg(report.unavailableRoots.size())
+                                         .arg(report.unavailableRoots.join(", ")), 6000);
+        }
+    });
+    QTimer::singleShot(30000, indexSweeper, &IndexSweeper::start);
+
+    // ✅ Incremental indexing: watch every folder that has been scanned before
+    libraryWatcher = new LibraryWatcher(this);
+    connect(libraryWatcher, &LibraryWatcher::filesChanged, this, &MainWindow::indexChangedFiles);
+    QTimer::singleShot(0, this, [this]() {
+        const QHash<QString, bool> roots = FaceDatabaseManager::instance().libraryRoots();
+        for (auto it = roots.constBegin(); it != roots.constEnd(); ++it)
+            libraryWatcher->addRoot(it.key(), it.value());
+    });
+
+    // ✅ Vector mirror: a missing or outdated file is rebuilt here, not by whichever thread reads it first
+    QFuture<void> store = QtConcurrent::run([]() {
+        EmbeddingStore::instance().prepare();
+    });
+
+    // Older databases: assign identities and build the folder summaries once, off the UI thread
+    QFuture<void> _ = QtConcurrent::run([this]() {
+        if (FaceDatabaseManager::instance().ensureFolderSummaries()) {
+            QMetaObject::invokeMethod(this, [this]() {
+                if (!currentPath.isEmpty())
+                    loadFaceListFromDatabase();
+            }, Qt::QueuedConnection);
+        }
+    });
+
     // ==== Startup View ====
     goHome();
 }
 
 
 MainWindow::~MainWindow() {
+    shuttingDown = true;
     scanAbortFlag = true;
     thumbAbortFlag = true;
+    delete prefetcher;  // waits for a running pass before the write queue shuts down
+    prefetcher = nullptr;
+    indexSweeper->stop();
+    FaceWriteQueue::instance().shutdown();
 }
 
 
 void MainWindow::goHome() {
     abortCurrentScansTemporarily();
+    thumbnailScheduler->reset();
     scanAbortFlag = true;
     pathLabel->setText("This PC");
     currentPath.clear();
@@ -405,6 +355,7 @@ void MainWindow::goBack() {
 }
 
 void MainWindow::navigateTo(const QString &path, bool addToHistory) {
+    prefetcher->pause();
     abortCurrentScansTemporarily();
     scanAbortFlag = false;
     if (!QDir(path).exists()) return;
@@ -415,6 +366,7 @@ void MainWindow::navigateTo(const QString &path, bool addToHistory) {
     loadFolder(path);
     stack->setCurrentWidget(folderView);
     loadFaceListFromDatabase();
+    prefetcher->setContext(path, navHistory.mid(qMax(0, navHistory.size() - 6)), includeSubfolders);
 }
 
 void MainWindow::loadDrives() {
@@ -435,104 +387,11 @@ void MainWindow::loadFolder(const QString &path) {
         thumbAbortFlag = false;
     });
 
-    folderView->clear();
-    QDir dir(path);
-    QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
-    QFileIconProvider iconProvider;
-
-    std::sort(entries.begin(), entries.end(), [](const QFileInfo& a, const QFileInfo& b) {
-        if (a.isDir() != b.isDir()) return a.isDir();
-        return a.fileName().toLower() < b.fileName().toLower();
-    });
-
-    for (const auto& entry : entries) {
-        QListWidgetItem *item = nullptr;
-
-        if (entry.isDir()) {
-            QDir folder(entry.absoluteFilePath());
-            QFileInfoList files = folder.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
-
-            bool hasImage = false;
-            bool isEmpty = files.isEmpty();
-
-            for (const auto& file : files) {
-                QString ext = file.suffix().toLower();
-                if (ext == "jpg" || ext == "jpeg" || ext == "png" || ext == "bmp") {
-                    hasImage = true;
-                    break;
-                }
-            }
-
-            if (!hasImage && !isEmpty) continue;  // ⛔ Skip folder with only non-image files
-
-            item = new QListWidgetItem(iconProvider.icon(entry), entry.fileName());
-            // ✅ Set initial flags for folders
-            item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-        }
-        else {
-            QString ext = entry.suffix().toLower();
-            if (!(ext == "jpg" || ext == "jpeg" || ext == "png" || ext == "bmp"))
-                continue;
-
-            QString imagePath = entry.absoluteFilePath();
-            qDebug() << "📥 Queued image:" << imagePath;
-
-            // Show placeholder first
-            QListWidgetItem* item = new QListWidgetItem(QIcon(":/icons/placeholder.png"), entry.fileName());
-            item->setToolTip(imagePath);
-            item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-            item->setData(Qt::UserRole, imagePath);
-
-            int itemRow = folderView->count();  // Capture position
-            folderView->addItem(item);          // Add it BEFORE launching the thread
-
-            QPointer<QListWidget> list = folderView;
-
-            QFuture<void> _ = QtConcurrent::run([this, imagePath, list, itemRow]() {
-                qDebug() << "🔄 [Thread] Generating thumbnail for:" << imagePath;
-
-                if (scanAbortFlag) {
-                    qDebug() << "⏹️ [Thread] Skipped due to scanAbortFlag:" << imagePath;
-                    return;
-                }
-
-                QPixmap thumb = getCachedThumbnail(imagePath, QSize(128, 128));
-
-                if (!scanAbortFlag && !thumb.isNull()) {
-                    QMetaObject::invokeMethod(list, [=]() {
-                        if (scanAbortFlag || !list) {
-                            qWarning() << "⚠️ Skipped UI update — scan aborted or list deleted for" << imagePath;
-                            return;
-                        }
-
-                        if (itemRow < 0 || itemRow >= list->count()) {
-                            qWarning() << "⚠️ Skipped UI update — invalid itemRow" << itemRow << "for" << imagePath;
-                            return;
-                        }
-
-                        QListWidgetItem* item = list->item(itemRow);
-                        if (!item) {
-                            qWarning() << "⚠️ Skipped UI update — item at row" << itemRow << "was null for" << imagePath;
-                            return;
-                        }
+    // New folder: queued thumbnails of the old one are dropped, late results ignored
+    thumbnailScheduler->reset();
 
-                        item->setIcon(QIcon(thumb));
-                        qDebug() << "✅ [UI] Set thumbnail for:" << imagePath;
-                    });
-
-                } else {
-                    qWarning() << "❌ [Thread] Failed to generate thumbnail for:" << imagePath;
-                }
-            });
-        }
-
-        if (item && entry.isDir()) {
-            item->setToolTip(entry.absoluteFilePath());
-            item->setData(Qt::UserRole, entry.absoluteFilePath());
-            folderView->addItem(item);
-        }
-
-    }
+    // ✅ Listing, sorting and subfolder probes run off the UI thread; rows page in as the view scrolls
+    folderModel->setDirectory(path);
 }
 
 void MainWindow::refresh() {
@@ -542,194 +401,183 @@ void MainWindow::refresh() {
         return;
     }
 
+    prefetcher->pause();
     abortCurrentScansTemporarily();
+    // Explicit refresh: list from disk even if the folder's mtime says nothing changed
+    DirectoryCache::instance().invalidate(currentPath);
     navigateTo(currentPath);
+    ++faceListGeneration;  // the scan below fills the face list, not the stored summary
     faceList->clear();
     personList.clear();
 
     statusBar()->showMessage("🔍 Detecting faces in background...", 3000);
 
+    // Watch what this scan covers: the folder alone unless subfolders are included
+    FaceDatabaseManager::instance().addLibraryRoot(currentPath, includeSubfolders);
+    libraryWatcher->addRoot(currentPath, includeSubfolders);
+
     QFuture<void> future = QtConcurrent::run([this]() {
         QDirIterator it(currentPath,
-                        QStringList() << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp",
+                        ScanPipeline::imageNameFilters(),
                         QDir::Files,
                         includeSubfolders ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
 
+        scanPipeline.resetSession();
+
         while (it.hasNext()) {
-            QString path = it.next();
-            QFileInfo info(path);
-            qint64 mtime = info.lastModified().toSecsSinceEpoch();
-            if (faceIndexer.faceAlreadyProcessed(path, mtime)) {
-                qDebug() << "⏭️ Skipping cached:" << path;
-                continue;
+            ScanResult result = scanPipeline.processFile(it.next());
+            if (result.outcome == ScanOutcome::Analysed)
+                addScannedFacesToPersonList(result);
+        }
+        
+        if (!scanAbortFlag) {
+            QMetaObject::invokeMethod(this, [this]() {
+                if (!scanAbortFlag && faceList && statusBar()) {
+                    updateFaceList();
+                    statusBar()->showMessage(QString("🧠 Faces detected: %1").arg(personList.size()), 2000);
+                }
+            }, Qt::QueuedConnection);
+        }
+
+    });
+}
+
+void MainWindow::indexChangedFiles(const QStringList& changed, const QStringList& removed) {
+    QString folder = currentPath;
+    prefetcher->pause();
+
+    // Edits inside a file leave its folder's mtime alone, so drop the cached listing explicitly
+    DirectoryCache::instance().invalidateFiles(changed + removed);
+
+    QFuture<void> _ = QtConcurrent::run([this, changed, removed, folder]() {
+        int analysed = 0;
+
+        // Changed files first: a move shows up as removed+created, and the
+        // created side rewrites the old rows via rename detection.
+        // ✅ Not scanAbortFlag: navigation sets that, and the watcher never reports these files again
+        for (const QString& path : changed) {
+            if (shuttingDown) break;
+            if (scanPipeline.processFile(path).outcome != ScanOutcome::Skipped)
+                ++analysed;
+        }
+
+        QStringList gone;
+        for (const QString& path : removed) {
+            if (!QFileInfo::exists(path))
+                gone << path;
+        }
+        FaceWriteQueue::instance().flush();
+        FaceDatabaseManager::instance().removePaths(gone);
+
+        bool touchesView = false;
+        for (const QString& path : changed + removed) {
+            QString parent = QFileInfo(path).absolutePath();
+            if (parent == folder || (includeSubfolders && parent.startsWith(folder + "/"))) {
+                touchesView = true;
+                break;
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, analysed, gone, touchesView, folder]() {
+            statusBar()->showMessage(QString("📂 Indexed %1 changed file(s), removed %2").arg(analysed).arg(gone.size()), 3000);
+            if (touchesView && currentPath == folder) {
+                loadFolder(currentPath);
+                loadFaceListFromDatabase();
             }
+        }, Qt::QueuedConnection);
+    });
+}
 
+void MainWindow::addScannedFacesToPersonList(const ScanResult& result) {
+    const QString& path = result.path;
 
-            cv::Mat fullRes = cv::imread(path.toStdString());
-            if (fullRes.empty()) continue;
-
-            cv::Size resizedSize;
-            double scaleX = 1.0, scaleY = 1.0;
-            ResizeMode mode = ResizeMode::Original; //Fit1280x720;  // 🔁 or Fit1024x1024 or Original
-            cv::Mat matBGR = resizeImageForDetection(fullRes, mode, resizedSize, scaleX, scaleY);
-
-            if (matBGR.empty()) continue;
-
-            auto faces = faceDetector.detectFaces(matBGR);
-            qDebug() << "🧠" << faces.size() << "face(s) found in:" << path;
-
-            std::vector<QRect> faceRects;
-            std::vector<std::vector<float>> embeddings;
-            std::vector<double> symmetries;
-            std::vector<double> focuses;
-
-            for (const QRect& rect : faces) {
-                auto embedding = faceDetector.getJitteredEmbedding(matBGR, rect);
-                if (embedding.empty()) continue;
-                //embedding = normalizeEmbedding(embedding);
-                qDebug() << "📸 In file:" << path << "📐 Face Size:" << rect.width() << "x" << rect.height();
-
-                if (rect.width() < 20 || rect.height() < 20) continue;
-                if (rect.width() > 1000 || rect.height() > 1000) continue;
-
-                dlib::rectangle dlibRect(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height());
-                dlib::cv_image<dlib::bgr_pixel> dlibImg(matBGR);
-                auto shape = faceDetector.getLandmarks(dlibImg, dlibRect);
-                double symmetry = getSymmetryScore(shape);
-
-                QRect scaled(
-                    int(rect.x() * scaleX),
-                    int(rect.y() * scaleY),
-                    int(rect.width() * scaleX),
-                    int(rect.height() * scaleY)
-                    );
-
-                cv::Rect roi(scaled.x(), scaled.y(), scaled.width(), scaled.height());
-                roi &= cv::Rect(0, 0, fullRes.cols, fullRes.rows);
-                cv::Mat faceMat = fullRes(roi).clone();
-
-                cv::resize(faceMat, faceMat, cv::Size(64, 64));
-                double focus = getFocusScore(faceMat);
-                QImage faceImg(faceMat.data, faceMat.cols, faceMat.rows, faceMat.step, QImage::Format_BGR888);
-                QPixmap thumb = QPixmap::fromImage(faceImg.copy());
-
-                bool matched = false;
-                for (size_t i = 0; i < personList.size(); ++i) {
-                    if (isSimilarFace(embedding, personList[i].embedding, matchDIST)) {
-                        matched = true;
-                        personList[i].count += 1;
-
-                        if (eyesAreOpen(shape)) {
-                            double prevFocus = personList[i].focus;
-                            bool focusGood = focus >= goodFocusThreshold;
-                            bool focusAcceptable = focus >= (prevFocus - focusTolerance);
-
-                            if (symmetry < personList[i].symmetry && (focusGood || focusAcceptable)) {
-                                personList[i].embedding = embedding;
-                                personList[i].symmetry = symmetry;
-                                personList[i].focus = focus;
-                                personList[i].thumb = thumb;
-                                personList[i].imagePath = path;
-
-                                if (!scanAbortFlag) {
-                                    QMetaObject::invokeMethod(this, [=]() {
-                                        if (!scanAbortFlag && faceList && i < faceList->count()) {
-                                            faceList->item(static_cast<int>(i))->setIcon(QIcon(thumb));
-                                            faceList->item(static_cast<int>(i))->setText(
-                                                QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
-                                        }
-                                    }, Qt::QueuedConnection);
-                                }
+    for (const ScannedFace& face : result.faces) {
+        const std::vector<float>& embedding = face.embedding;
+        double symmetry = face.symmetry;
+        double focus = face.focus;
+        QPixmap thumb = QPixmap::fromImage(face.thumb);
 
-                            } else {
-                                if (!scanAbortFlag) {
-                                    QMetaObject::invokeMethod(this, [=]() {
-                                        if (!scanAbortFlag && faceList && i < faceList->count()) {
-                                            faceList->item(static_cast<int>(i))->setText(
-                                                QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
-                                        }
-                                    }, Qt::QueuedConnection);
+        bool matched = false;
+        for (size_t i = 0; i < personList.size(); ++i) {
+            if (isSimilarFace(embedding, personList[i].embedding, matchDIST)) {
+                matched = true;
+                personList[i].count += 1;
+
+                if (face.eyesOpen) {
+                    double prevFocus = personList[i].focus;
+                    bool focusGood = focus >= goodFocusThreshold;
+                    bool focusAcceptable = focus >= (prevFocus - focusTolerance);
+
+                    if (symmetry < personList[i].symmetry && (focusGood || focusAcceptable)) {
+                        personList[i].embedding = embedding;
+                        personList[i].symmetry = symmetry;
+                        personList[i].focus = focus;
+                        personList[i].thumb = thumb;
+                        personList[i].imagePath = path;
+
+                        if (!scanAbortFlag) {
+                            QMetaObject::invokeMethod(this, [=]() {
+                                if (!scanAbortFlag && faceList && i < faceList->count()) {
+                                    faceList->item(static_cast<int>(i))->setIcon(QIcon(thumb));
+                                    faceList->item(static_cast<int>(i))->setText(
+                                        QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
                                 }
+                            }, Qt::QueuedConnection);
+                        }
 
-                            }
-                        } else {
-                            if (!scanAbortFlag) {
-                                QMetaObject::invokeMethod(this, [=]() {
-                                    if (!scanAbortFlag && faceList && i < faceList->count() && faceList->item(i)) {
-                                        faceList->item(static_cast<int>(i))->setText(
-                                            QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
-                                    }
-                                }, Qt::QueuedConnection);
-                            }
-
+                    } else {
+                        if (!scanAbortFlag) {
+                            QMetaObject::invokeMethod(this, [=]() {
+                                if (!scanAbortFlag && faceList && i < faceList->count()) {
+                                    faceList->item(static_cast<int>(i))->setText(
+                                        QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
+                                }
+                            }, Qt::QueuedConnection);
                         }
-                        break;
-                    }
-                }
 
-                if (!matched) {
-                    personList.push_back({embedding, symmetry, focus, thumb, path});
+                    }
+                } else {
                     if (!scanAbortFlag) {
                         QMetaObject::invokeMethod(this, [=]() {
-                            if (!scanAbortFlag && faceList) {
-                                QString label = QString("Person %1 (1)").arg(personList.size());
-                                QListWidgetItem* item = new QListWidgetItem(QIcon(thumb), label);
-                                item->setToolTip(path);
-                                item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
-                                item->setCheckState(Qt::Unchecked);
-                                faceList->addItem(item);
+                            if (!scanAbortFlag && faceList && i < faceList->count() && faceList->item(i)) {
+                                faceList->item(static_cast<int>(i))->setText(
+                                    QString("Person %1 (%2)").arg(i + 1).arg(personList[i].count));
                             }
                         }, Qt::QueuedConnection);
                     }
-                }
 
-                faceRects.push_back(rect);
-                embeddings.push_back(embedding);
-                symmetries.push_back(symmetry);
-                focuses.push_back(focus);
+                }
+                break;
             }
+        }
 
-            QList<FaceEntry> faceEntries;
-            QList<std::vector<float>> embeddingList;
-
-            for (int i = 0; i < static_cast<int>(faceRects.size()); ++i) {
-                FaceEntry entry;
-                entry.imagePath = path;
-                entry.faceRect = faceRects[i];
-                entry.quality = focuses[i];
-                entry.globalId = "";  // leave empty for now
-                faceEntries.append(entry);
-                embeddingList.append(embeddings[i]);
+        if (!matched) {
+            personList.push_back({embedding, symmetry, focus, thumb, path});
+            if (!scanAbortFlag) {
+                QMetaObject::invokeMethod(this, [=]() {
+                    if (!scanAbortFlag && faceList) {
+                        QString label = QString("Person %1 (1)").arg(personList.size());
+                        QListWidgetItem* item = new QListWidgetItem(QIcon(thumb), label);
+                        item->setToolTip(path);
+                        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+                        item->setCheckState(Qt::Unchecked);
+                        faceList->addItem(item);
+                    }
+                }, Qt::QueuedConnection);
             }
-
-            FaceDatabaseManager::instance().addFacesBatch(faceEntries, embeddingList);
-
         }
-        
-        if (!scanAbortFlag) {
-            QMetaObject::invokeMethod(this, [this]() {
-                if (!scanAbortFlag && faceList && statusBar()) {
-                    updateFaceList();
-                    statusBar()->showMessage(QString("🧠 Faces detected: %1").arg(personList.size()), 2000);
-                }
-            }, Qt::QueuedConnection);
-        }
-
-    });
+    }
 }
 
 
 bool MainWindow::isSimilarFace(const std::vector<float>& a, const std::vector<float>& b, float threshold) {
-    float dist = l2Distance(a, b);
-    bool isMatch = dist < threshold;
-
-    qDebug() << (isMatch ? "✅ Match" : "❌ No Match")
-             << " | Distance:" << dist
-             << " | Threshold:" << threshold;
-
-    return isMatch;
+    return isSimilarFace(a, EmbeddingView { b.data(), b.size() }, threshold);
 }
 
+bool MainWindow::isSimilarFace(const std::vector<float>& a, const EmbeddingView& b, float threshold) {
+    // Called per face pair in tight loops: no logging here
+    return l2Distance(a, b) < threshold;
+}
 
 void MainWindow::showFolderViewContextMenu(const QPoint& pos) {
     QMenu menu(this);
@@ -747,17 +595,17 @@ void MainWindow::showFolderViewContextMenu(const QPoint& pos) {
     QAction* chosen = menu.exec(folderView->viewport()->mapToGlobal(pos));
 
     if (chosen == openAction) {
-        QListWidgetItem* item = folderView->itemAt(pos);
-        if (item) {
-            showImagePopup(item->data(Qt::UserRole).toString());
+        QModelIndex index = folderView->indexAt(pos);
+        if (index.isValid()) {
+            showImagePopup(index.data(FolderModel::PathRole).toString());
         }
     }
 
     else if (chosen == openWithAction) {
-        QListWidgetItem* item = folderView->itemAt(pos);
-        if (!item) return;
+        QModelIndex index = folderView->indexAt(pos);
+        if (!index.isValid()) return;
 
-        QString path = item->data(Qt::UserRole).toString();
+        QString path = index.data(FolderModel::PathRole).toString();
         QDesktopServices::openUrl(QUrl::fromLocalFile(path));
     }
 
@@ -781,22 +629,17 @@ void MainWindow::showImagePopup(const QString& path) {
     QFileInfo info(path);
     if (!info.exists() || !info.isFile()) return;
 
-    QImage image(path);
-    if (image.isNull()) return;
-
-    QDialog* dialog = new QDialog(this);
-    dialog->setWindowTitle(info.fileName());
-    dialog->resize(800, 600);
-
-    QLabel* label = new QLabel(dialog);
-    label->setPixmap(QPixmap::fromImage(image).scaled(dialog->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
-    label->setAlignment(Qt::AlignCenter);
-
-    QVBoxLayout* layout = new QVBoxLayout(dialog);
-    layout->addWidget(label);
-    dialog->setLayout(layout);
+    // ✅ Decodes off the UI thread at screen size; Left/Right step through the folder
+    QStringList images = folderModel->imagePaths();
+    int index = images.indexOf(path);
+    if (index < 0) {
+        images = { path };
+        index = 0;
+    }
 
-    dialog->exec();
+    prefetcher->pause();
+    ImageViewer viewer(images, index, this);
+    viewer.exec();
 }
 
 void MainWindow::pasteToCurrentFolder() {
@@ -814,6 +657,7 @@ void MainWindow::pasteToCurrentFolder() {
     static bool userChoseOverwrite = false;
 
     int overwriteCount = 0, skippedCount = 0;
+    QList<QPair<QString, QString>> movedPaths;
 
     for (const auto& src : copiedFilePaths) {
         QFileInfo srcInfo(src);
@@ -852,24 +696,51 @@ void MainWindow::pasteToCurrentFolder() {
             ++overwriteCount;
         }
 
-        if (QFile::copy(src, destPath)) {
-            if (cutMode) {
-                QFile srcFile(src);
+        if (cutMode) {
+            // ✅ Move in place when possible and carry the index rows along, so nothing is re-detected
+            bool moved = false;
+            if (srcInfo.isDir()) {
+                moved = QDir().rename(src, destPath);
+            } else {
+                if (QFile::exists(destPath))
+                    QFile::remove(destPath);  // user already agreed to overwrite
+                moved = QFile::rename(src, destPath);
+
+                if (!moved && QFile::copy(src, destPath)) {
+                    QFile srcFile(src);
 
-                // First attempt to remove
-                if (!srcFile.remove()) {
-                    // Try force permissions and retry
-                    srcFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+                    // First attempt to remove
                     if (!srcFile.remove()) {
-                        qWarning() << "❌ Failed to remove file after cut:" << src << "Error:" << srcFile.errorString();
+                        // Try force permissions and retry
+                        srcFile.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+                        if (!srcFile.remove()) {
+                            qWarning() << "❌ Failed to remove file after cut:" << src << "Error:" << srcFile.errorString();
+                        }
                     }
+                    moved = !srcFile.exists();
                 }
             }
+
+            if (moved) {
+                movedPaths.append({ src, destPath });
+            } else {
+                qWarning() << "❌ Failed to move:" << src << "->" << destPath;
+            }
+        } else {
+            QFile::copy(src, destPath);
         }
     }
 
     cutMode = false;
 
+    if (!movedPaths.isEmpty()) {
+        QFuture<void> _ = QtConcurrent::run([movedPaths]() {
+            FaceWriteQueue::instance().flush();  // rows for the sources may still be queued
+            for (const auto& move : movedPaths)
+                FaceDatabaseManager::instance().movePath(move.first, move.second);
+        });
+    }
+
     bool copiedAny = (overwriteCount > 0 || copiedFilePaths.size() > skippedCount);
 
     statusBar()->showMessage(
@@ -901,8 +772,8 @@ void MainWindow::performCopy() {
 
     // Fallback to folderView selection if no face is checked
     if (!anyFaceChecked) {
-        for (auto& item : folderView->selectedItems())
-            copiedFilePaths << item->data(Qt::UserRole).toString();
+        for (const QModelIndex& index : folderView->selectionModel()->selectedIndexes())
+            copiedFilePaths << index.data(FolderModel::PathRole).toString();
     }
 
     cutMode = false;
@@ -911,8 +782,8 @@ void MainWindow::performCopy() {
 
 void MainWindow::performCut() {
     copiedFilePaths.clear();
-    for (auto& item : folderView->selectedItems())
-        copiedFilePaths << item->data(Qt::UserRole).toString();
+    for (const QModelIndex& index : folderView->selectionModel()->selectedIndexes())
+        copiedFilePaths << index.data(FolderModel::PathRole).toString();
     cutMode = true;
     statusBar()->showMessage(QString("✂️ Cut %1 files").arg(copiedFilePaths.size()), 2000);
 }
@@ -946,7 +817,7 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
             break;
         }
     } else if (event->key() == Qt::Key_Delete) {
-        QList<QListWidgetItem*> selectedItems = folderView->selectedItems();
+        const QModelIndexList selectedItems = folderView->selectionModel()->selectedIndexes();
         if (selectedItems.isEmpty()) return;
 
         int confirm = QMessageBox::question(this, "Delete Files",
@@ -955,10 +826,18 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
                                             QMessageBox::Yes | QMessageBox::No);
 
         if (confirm == QMessageBox::Yes) {
-            for (auto& item : selectedItems) {
-                QString path = item->data(Qt::UserRole).toString();
-                QFile::remove(path);
+            QStringList removed;
+            for (const QModelIndex& index : selectedItems) {
+                QString path = index.data(FolderModel::PathRole).toString();
+                if (QFile::remove(path))
+                    removed << path;
             }
+
+            // ✅ Drop their index rows right away instead of waiting for the sweeper
+            QFuture<void> _ = QtConcurrent::run([removed]() {
+                FaceWriteQueue::instance().flush();
+                FaceDatabaseManager::instance().removePaths(removed);
+            });
             loadFolder(currentPath);
             statusBar()->showMessage("🗑️ Deleted selected files", 2000);
         }
@@ -1002,109 +881,188 @@ void MainWindow::updateFaceList() {
 }
 
 void MainWindow::updateFolderViewThumbnails(const QString& folder) {
-    for (int i = 0; i < folderView->count(); ++i) {
-        QListWidgetItem* item = folderView->item(i);
-        QString imagePath = item->data(Qt::UserRole).toString();
-        QFileInfo info(imagePath);
+    // Only the folder on screen has thumbnails to refresh
+    if (QDir(folderModel->directory()) != QDir(folder))
+        return;
+    folderModel->invalidateThumbnails();
+    requestVisibleThumbnails();
+}
 
-        // Only apply to files (not folders) inside the target folder
-        if (!info.isFile() || info.absolutePath() != folder)
-            continue;
+// ✅ Only what is on screen plus one screen below is decoded, top to bottom
+void MainWindow::requestVisibleThumbnails() {
+    const int count = folderModel->rowCount();
+    const QRect view = folderView->viewport()->rect();
+    const int lookahead = view.height();
+
+    // Icon mode lays rows out top to bottom in row order: binary search the first visible one
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (folderView->visualRect(folderModel->index(mid)).bottom() < view.top())
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-        // Run thumbnail loading in background
-        QFuture<void> future = QtConcurrent::run([=]() {
-            QPixmap thumb = getCachedThumbnail(imagePath, QSize(128, 128));
-            if (!scanAbortFlag && !thumb.isNull()) {
-                QMetaObject::invokeMethod(folderView, [=]() {
-                    if (!scanAbortFlag && folderView && item && folderView->indexFromItem(item).isValid()) {
-                        item->setIcon(QIcon(thumb));
-                    }
-                }, Qt::QueuedConnection);
-            }
+    QList<ThumbnailRequest> wanted;
+    for (int row = lo; row < count; ++row) {
+        const QModelIndex index = folderModel->index(row);
+        if (folderView->visualRect(index).top() > view.bottom() + lookahead)
+            break;
+        if (index.data(FolderModel::IsDirRole).toBool() || index.data(FolderModel::ThumbnailLoadedRole).toBool())
+            continue;
 
-        });
+        // No mtime yet (cache key): the job stats the file itself rather than wait for the listing
+        qint64 mtime = index.data(FolderModel::ModifiedRole).toLongLong();
+        wanted.append({ index.data(FolderModel::PathRole).toString(), mtime });
     }
+    thumbnailScheduler->setWanted(wanted);
+    if (thumbnailScheduler->pending() > 0)
+        prefetcher->pause();  // the screen comes first
+}
+
+void MainWindow::setFolderZoom(int edge) {
+    folderIconEdge = edge;
+    folderView->setIconSize(QSize(edge, edge));
+    folderView->setGridSize(QSize(edge + 12, edge + 44));
+
+    // ✅ Nearest tier that is not upscaled; crossing into another tier swaps thumbnails in place
+    const int tier = ThumbnailStore::tierFor(edge);
+    if (tier == thumbnailScheduler->tier())
+        return;
+
+    thumbnailScheduler->setTier(tier);
+    prefetcher->setTier(tier);
+    folderModel->invalidateThumbnails();
+    thumbnailViewportTimer->start();
 }
 
 void MainWindow::updateFolderViewCheckboxesFromFaceSelection() {
     QVector<std::vector<float>> selectedEmbeddings;
+    QSet<QString> selectedIds;
 
     for (int i = 0; i < faceList->count(); ++i) {
         if (faceList->item(i)->checkState() == Qt::Checked) {
             selectedEmbeddings.push_back(personList[i].embedding);
+            if (!personList[i].globalId.isEmpty())
+                selectedIds.insert(personList[i].globalId);
         }
     }
 
-    for (int i = 0; i < folderView->count(); ++i) {
-        QListWidgetItem* item = folderView->item(i);
-        QString path = item->data(Qt::UserRole).toString();
-        QFileInfo info(path);
-
-        if (!info.isFile()) continue;
-
-        // Always allow user to manually check/uncheck
-        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
-        item->setCheckState(Qt::Unchecked);  // default to unchecked
-
-        // Skip matching logic if no face selected
-        if (selectedEmbeddings.isEmpty()) continue;
-
-        QList<FaceEntry> faces = includeSubfolders
-                                     ? FaceDatabaseManager::instance().getFaceEntriesInSubtree(currentPath)
-                                     : FaceDatabaseManager::instance().getFaceEntriesInFolder(info.absolutePath());
+    const quint64 generation = ++faceMatchGeneration;
+    if (selectedEmbeddings.isEmpty()) {
+        folderModel->setMatchedFiles({});
+        return;
+    }
 
-        for (const FaceEntry& face : faces) {
-            if (QFileInfo(face.imagePath).fileName() != info.fileName())
-                continue;
+    // The write fence, the face query and the matching all stay off the UI thread
+    const QString folder = currentPath;
+    const bool recursive = includeSubfolders;
+    QFuture<void> _ = QtConcurrent::run([this, generation, folder, recursive, selectedEmbeddings, selectedIds]() {
+        FaceWriteQueue::instance().flush();  // read-your-writes for faces still queued by a scan
+
+        // ✅ One query for the face rows of the whole view; their vectors are read from the mapped store
+        QSet<QString> matchedNames;
+        const QList<FaceRef> faces = FaceDatabaseManager::instance().faceRefs(folder, recursive);
+
+        // Indexed identities match exactly; embeddings cover scan-time people without one
+        QList<int> candidates;
+        QList<qint64> keys;
+        for (int i = 0; i < faces.size(); ++i) {
+            if (!faces[i].globalId.isEmpty() && selectedIds.contains(faces[i].globalId)) {
+                matchedNames.insert(QFileInfo(faces[i].imagePath).fileName());
+            } else {
+                candidates.append(i);
+                keys.append(faces[i].embeddingId);
+            }
+        }
 
-            std::vector<float> emb = FaceDatabaseManager::instance().getEmbeddingById(face.id);
+        auto matchFace = [&](const FaceRef& face, const EmbeddingView& emb) {
+            QString fileName = QFileInfo(face.imagePath).fileName();
+            if (matchedNames.contains(fileName))
+                return;
             for (const auto& selected : selectedEmbeddings) {
                 if (isSimilarFace(selected, emb, matchDIST)) {
-                    item->setCheckState(Qt::Checked);
-                    goto matched;
+                    matchedNames.insert(fileName);
+                    return;
                 }
             }
-        }
-    matched:;
-    }
-}
-
-void MainWindow::loadFaceListFromDatabase() {
-    personList.clear();
-
-    QList<FaceEntry> entries;
-    if (includeSubfolders) {
-        entries = FaceDatabaseManager::instance().getFaceEntriesInSubtree(currentPath);
-    } else {
-        entries = FaceDatabaseManager::instance().getFaceEntriesInFolder(currentPath);
-    }
-
-    for (const auto& face : entries) {
-        std::vector<float> emb = FaceDatabaseManager::instance().getEmbeddingById(face.id);
-        if (emb.empty()) continue;
+        };
 
-        QImage image(face.imagePath);
-        if (image.isNull()) continue;
-
-        QRect r = face.faceRect;
-        QImage faceImage = image.copy(r).scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        QPixmap thumb = QPixmap::fromImage(faceImage);
+        QVector<bool> mirrored(keys.size(), false);
+        EmbeddingStore::instance().visit(keys, [&](int k, const EmbeddingView& emb) {
+            mirrored[k] = true;
+            matchFace(faces[candidates[k]], emb);
+        });
 
-        bool matched = false;
-        for (auto& p : personList) {
-            if (isSimilarFace(p.embedding, emb, matchDIST)) {
-                p.count++;
-                matched = true;
-                break;
+        // Rows the store has not mirrored yet: their blobs in a few batched queries
+        QList<qint64> missing;
+        for (int k = 0; k < keys.size(); ++k) {
+            if (!mirrored[k]) missing.append(keys[k]);
+        }
+        if (!missing.isEmpty()) {
+            const QHash<qint64, QByteArray> blobs = FaceDatabaseManager::instance().embeddingsByIds(missing);
+            for (int k = 0; k < keys.size(); ++k) {
+                if (mirrored[k]) continue;
+                const QByteArray blob = blobs.value(keys[k]);
+                matchFace(faces[candidates[k]], EmbeddingView { reinterpret_cast<const float*>(blob.constData()),
+                                                                static_cast<size_t>(blob.size()) / sizeof(float) });
             }
         }
 
-        if (!matched) {
-            personList.push_back({emb, 0.0, 0.0, thumb, face.imagePath});
+        QMetaObject::invokeMethod(this, [this, generation, folder, matchedNames]() {
+            if (generation != faceMatchGeneration || folder != currentPath)
+                return;  // the selection or the folder changed while matching
+            folderModel->setMatchedFiles(matchedNames);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::loadFaceListFromDatabase() {
+    const quint64 generation = ++faceListGeneration;
+    const QString folder = currentPath;
+    const bool recursive = includeSubfolders;
+
+    // ✅ Read ahead while idle (Prefetcher) unless a write landed since
+    PrefetchedFaces prefetched;
+    const bool ready = prefetcher->takeFaces(folder, recursive, prefetched);
+
+    // Waiting for queued scan writes, the summary query and crop loading all stay off the UI thread
+    QFuture<void> _ = QtConcurrent::run([this, generation, folder, recursive, ready, prefetched]() mutable {
+        FaceDatabaseManager& db = FaceDatabaseManager::instance();
+        if (!ready) {
+            FaceWriteQueue::instance().flush();  // read-your-writes for faces still queued by a scan
+
+            // ✅ Materialized per-folder identities: one indexed lookup, one exemplar per person
+            prefetched.people = db.folderPersonSummary(folder, recursive);
+
+            // ✅ Exemplar crops come from the crop pack; only faces without one touch the photo
+            QList<FaceCropRequest> requests;
+            for (const FolderPerson& person : prefetched.people)
+                requests.append({ person.bestFaceId, person.bestImagePath, person.bestFaceRect });
+            prefetched.crops = FaceCropStore::instance().load(requests);
         }
-    }
 
-    updateFaceList();
+        QMetaObject::invokeMethod(this, [this, generation, prefetched]() {
+            if (generation != faceListGeneration)
+                return;  // another folder (or a scan) took over the face list
+
+            personList.clear();
+            for (int i = 0; i < prefetched.people.size(); ++i) {
+                const FolderPerson& person = prefetched.people[i];
+                QPixmap thumb;
+                const QImage crop = prefetched.crops.value(person.bestFaceId);
+                if (!crop.isNull())
+                    thumb = QPixmap::fromImage(crop);
+
+                FaceStats stats { person.embedding, 0.0, 0.0, thumb, person.bestImagePath };
+                stats.count = person.count;
+                stats.globalId = person.globalId;
+                personList.push_back(stats);
+            }
+            updateFaceList();
+        }, Qt::QueuedConnection);
+    });
 }
 
 void MainWindow::createNewFolder() {
@@ -3,10 +3,22 @@
 
 #include <QMainWindow>
 #include <QListWidget>
+#include <QListView>
 #include <QStackedWidget>
 #include <QLabel>
 #include <QStringList>
+#include <QHash>
 #include "faceDetector.h"
+#include "ScanPipeline.h"
+#include "FaceTypes.h"
+#include "IndexSweeper.h"
+#include "LibraryWatcher.h"
+#include "ThumbnailScheduler.h"
+
+class QTimer;
+class FolderModel;
+class Prefetcher;
+class FaceListItemDelegate;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,14 +31,18 @@ private:
     QLabel *pathLabel;
     QListWidget *faceList;
     QListWidget *driveList;
-    QListWidget *folderView;
+    QListView *folderView;
+    FolderModel *folderModel;
+    FaceListItemDelegate *folderDelegate = nullptr;
     QStackedWidget *stack;
 
     QString currentPath;
     QStringList navHistory;
     bool includeSubfolders = false;
 
-    FaceDetector faceDetector;
+    ScanPipeline scanPipeline;
+    IndexSweeper* indexSweeper = nullptr;
+    LibraryWatcher* libraryWatcher = nullptr;
     std::vector<std::vector<float>> knownEmbeddings;
     QStringList knownFaceThumbs;
 
@@ -34,6 +50,15 @@ private:
     bool showHiddenFolders = false;
     std::atomic_bool scanAbortFlag = false;
     std::atomic_bool thumbAbortFlag = false;
+    std::atomic_bool shuttingDown = false;     // only the destructor sets it; watcher batches stop on it
+
+    // Folder view thumbnails, keyed by absolute path
+    ThumbnailScheduler* thumbnailScheduler = nullptr;
+    QTimer* thumbnailViewportTimer = nullptr;
+    int folderIconEdge = 128;       // zoom; thumbnails come from ThumbnailStore::tierFor(folderIconEdge)
+    Prefetcher* prefetcher = nullptr;
+    quint64 faceListGeneration = 0;     // bumped per face list load; older results are dropped
+    quint64 faceMatchGeneration = 0;    // bumped per checkbox selection change; likewise
 
     bool cutMode = false;
     void pasteToCurrentFolder();
@@ -51,10 +76,13 @@ private:
         double focus,
         double symmetry);
 
+    void addScannedFacesToPersonList(const ScanResult& result);
+
     void loadDrives();
     void loadFolder(const QString &path);
     void navigateTo(const QString &path, bool addToHistory = true);
     bool isSimilarFace(const std::vector<float>& a, const std::vector<float>& b, float threshold = 0.6f); // ✅ stays here
+    bool isSimilarFace(const std::vector<float>& a, const EmbeddingView& b, float threshold = 0.6f);
 
 private slots:
     void goHome();
@@ -63,9 +91,12 @@ private slots:
     void updateFaceList();
     void loadFaceListFromDatabase();
     void updateFolderViewThumbnails(const QString& folder);
+    void requestVisibleThumbnails();
+    void setFolderZoom(int edge);
     void updateFolderViewCheckboxesFromFaceSelection();
     void createNewFolder();
     void abortCurrentScansTemporarily();
+    void indexChangedFiles(const QStringList& changed, const QStringList& removed);
 
 protected:
     void keyPressEvent(QKeyEvent* event) override;
@@ -0,0 +1,110 @@
+// Folder view paint benchmark: renders the grid delegate offscreen onto a
+// QImage, one screen-sized canvas at a time, and reports the cost per item.
+//
+//   photoexplorer-delegate-bench [--items N] [--size PX] [--passes N]
+//
+// The first pass starts with an empty pixmap cache (every icon is scaled
+// once), later passes repaint the same items the way scrolling back does.
+// Runs without a display: the offscreen platform is used unless
+// QT_QPA_PLATFORM says otherwise.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStandardItemModel>
+#include <QPainter>
+#include <QImage>
+#include <QIcon>
+#include <cstdio>
+
+#include "FaceListItemDelegate.h"
+#include "ThumbnailStore.h"
+
+// A handful of distinct stored-tier thumbnails, shared by all items like a real folder's packs
+static QList<QPixmap> benchThumbnails(int tier) {
+    QList<QPixmap> thumbs;
+    for (int i = 0; i < 16; ++i) {
+        QImage image(tier, tier * 3 / 4, QImage::Format_RGB32);
+        image.fill(QColor::fromHsv(i * 22, 160, 200));
+        QPainter p(&image);
+        p.setPen(Qt::white);
+        p.drawEllipse(image.rect().adjusted(tier / 8, tier / 8, -tier / 8, -tier / 8));
+        p.end();
+        thumbs.append(QPixmap::fromImage(image));
+    }
+    return thumbs;
+}
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("photoexplorer-delegate-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders the folder view delegate offscreen and reports paint time per item.");
+    parser.addHelpOption();
+    QCommandLineOption itemsOpt("items", "Items to paint per pass (default 500).", "N", "500");
+    QCommandLineOption sizeOpt("size", "Icon size in pixels, as set by the zoom slider (default 128).", "PX", "128");
+    QCommandLineOption passesOpt("passes", "Passes over all items; the first one is cold (default 3).", "N", "3");
+    parser.addOptions({ itemsOpt, sizeOpt, passesOpt });
+    parser.process(app);
+
+    const int items = parser.value(itemsOpt).toInt();
+    const int size = parser.value(sizeOpt).toInt();
+    const int passes = parser.value(passesOpt).toInt();
+    if (items < 1 || size < 16 || passes < 1) {
+        std::fprintf(stderr, "error: --items and --passes must be positive, --size at least 16\n");
+        return 1;
+    }
+
+    // Same shape as the folder model: a fresh QIcon per item from the tier the scheduler would load
+    int tier = ThumbnailStore::tiers().last();
+    for (int t : ThumbnailStore::tiers()) {
+        if (t >= size) { tier = t; break; }
+    }
+    const QList<QPixmap> thumbs = benchThumbnails(tier);
+    QStandardItemModel model;
+    for (int i = 0; i < items; ++i) {
+        auto* item = new QStandardItem(QIcon(thumbs[i % thumbs.size()]), QString("IMG_%1.jpg").arg(i, 5, 10, QChar('0')));
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        model.appendRow(item);
+    }
+
+    FaceListItemDelegate delegate(FaceListItemDelegate::FolderViewMode);
+
+    QStyleOptionViewItem option;
+    option.decorationSize = QSize(size, size);
+    option.state = QStyle::State_Enabled;
+    option.font = QApplication::font();
+    option.palette = QApplication::palette();
+    option.fontMetrics = QFontMetrics(option.font);
+    const QSize cell = delegate.sizeHint(option, model.index(0, 0));
+
+    // One full-HD canvas; items flow across it like the icon grid and wrap to the top when it is full
+    QImage canvas(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    const int columns = qMax(1, canvas.width() / cell.width());
+    const int rows = qMax(1, canvas.height() / cell.height());
+    std::fprintf(stderr, "%d item(s), %dpx icons from the %dpx tier, %dx%d cells, %d per screen\n",
+                 items, size, tier, cell.width(), cell.height(), columns * rows);
+
+    for (int pass = 0; pass < passes; ++pass) {
+        canvas.fill(Qt::white);
+        QPainter painter(&canvas);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < items; ++i) {
+            const int slot = i % (columns * rows);
+            option.rect = QRect(QPoint((slot % columns) * cell.width(), (slot / columns) * cell.height()), cell);
+            option.state = (i % 10 == 0) ? QStyle::State_Enabled | QStyle::State_Selected : QStyle::State_Enabled;
+            delegate.paint(&painter, option, model.index(i, 0));
+        }
+        painter.end();
+        const qint64 ns = timer.nsecsElapsed();
+        std::fprintf(stderr, "pass %d (%s): %.2f ms = %.1f us/item, %.1f ms per screen\n", pass + 1,
+                     pass == 0 ? "cold" : "warm", ns / 1e6, ns / 1e3 / items,
+                     ns / 1e6 / items * qMin(items, columns * rows));
+    }
+    return 0;
+}